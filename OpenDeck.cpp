@@ -28,10 +28,19 @@ void getNoteOnData(uint8_t channel, uint8_t note, uint8_t velocity)  {
 
 }
 
+void getControlChangeData(uint8_t channel, uint8_t ccNumber, uint8_t ccValue)    {
+
+    openDeck.storeReceivedControlChange(channel, ccNumber, ccValue);
+
+}
+
 void getSysExData(uint8_t *sysExArray, uint8_t size)    {
 
     openDeck.processSysEx(sysExArray, size);
 
+    //running status could be changed
+    MIDI.setRunningStatusTX(openDeck.runningStatusEnabled());
+
 }
 
 
@@ -68,16 +77,31 @@ void sendPotCCData(uint8_t ccNumber, uint8_t ccValue, uint8_t channel) {
 
 }
 
-void sendPotNoteOnData(uint8_t note, uint8_t channel)    {
+void sendEncoderData(uint8_t ccNumber, uint8_t ccValue, uint8_t channel)   {
+
+    //relative values are steps, coalescing would lose them
+    MIDI.sendControlChange(ccNumber, ccValue, channel, MIDI_PRIORITY_HIGH);
+
+}
+
+void sendPotNoteData(uint8_t noteOff, uint8_t noteOffChannel, uint8_t noteOn, uint8_t noteOnChannel)    {
+
+    //note 128 means there's nothing to send, pair is queued back to back so
+    //note off sent as note on shares running status with following note on
+    if (noteOff < 128)  {
+
+        if (openDeck.standardNoteOffEnabled())  MIDI.sendNoteOff(noteOff, MIDI_NOTE_OFF_VELOCITY, noteOffChannel, MIDI_PRIORITY_NORMAL);
+        else                                    MIDI.sendNoteOn(noteOff, MIDI_NOTE_OFF_VELOCITY, noteOffChannel, MIDI_PRIORITY_NORMAL);
+
+    }
 
-    MIDI.sendNoteOn(note, MIDI_NOTE_ON_VELOCITY, channel);
+    if (noteOn < 128)   MIDI.sendNoteOn(noteOn, MIDI_NOTE_ON_VELOCITY, noteOnChannel, MIDI_PRIORITY_NORMAL);
 
 }
 
-void sendPotNoteOffData(uint8_t note, uint8_t channel)   {
+void sendPotPP(uint8_t channel, uint8_t program)    {
 
-    if (openDeck.standardNoteOffEnabled())  MIDI.sendNoteOff(note, MIDI_NOTE_OFF_VELOCITY, channel);
-    else                                    MIDI.sendNoteOn(note, MIDI_NOTE_OFF_VELOCITY, channel);
+    MIDI.sendProgramChange(program, channel);
 
 }
 
@@ -95,8 +119,10 @@ void setOpenDeckHandlers()  {
     openDeck.setHandleButtonPPSend(sendButtonPP);
 
     openDeck.setHandlePotCC(sendPotCCData);
-    openDeck.setHandlePotNoteOn(sendPotNoteOnData);
-    openDeck.setHandlePotNoteOff(sendPotNoteOffData);
+    openDeck.setHandlePotNote(sendPotNoteData);
+    openDeck.setHandlePotPP(sendPotPP);
+
+    openDeck.setHandleEncoder(sendEncoderData);
 
     openDeck.setHandleSysExSend(sendSysExData);
 
@@ -106,6 +132,7 @@ void setOpenDeckHandlers()  {
 void setMIDIhandlers()  {
 
     MIDI.setHandleNoteOn(getNoteOnData);
+    MIDI.setHandleControlChange(getControlChangeData);
     MIDI.setHandleSystemExclusive(getSysExData);
 
 }
@@ -120,8 +147,8 @@ void setup()  {
     setMIDIhandlers();
 
     //read incoming MIDI messages on specified channel
-    //disable running status by default
-    MIDI.begin(openDeck.getInputMIDIchannel());
+    //running status for outgoing messages is set with MIDI feature
+    MIDI.begin(openDeck.getInputMIDIchannel(), openDeck.runningStatusEnabled());
 
     Serial.begin(38400);
 
@@ -141,6 +168,9 @@ void loop() {
     //read pots one analogue input at the time
     openDeck.readPots();
 
+    //send MIDI messages waiting for free space in TX buffer
+    MIDI.update();
+
     //openDeck.readEncoders(encoder1.read());
 
 }
\ No newline at end of file
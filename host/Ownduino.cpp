@@ -0,0 +1,151 @@
+/*
+
+OpenDECK host simulator v1.3
+File: Ownduino.cpp
+Last revision date: 2014-12-25
+Author: Igor Petrovic
+
+*/
+
+#include "Ownduino.h"
+
+HardwareSerial Serial;
+
+
+//time
+
+uint32_t millis()   {
+
+    virtualAVR.advance(CYCLES_REGISTER_ACCESS);
+    return virtualAVR.getMillis();
+
+}
+
+uint32_t micros()   {
+
+    virtualAVR.advance(CYCLES_REGISTER_ACCESS);
+    return virtualAVR.getMicros();
+
+}
+
+void delay(uint32_t ms) {
+
+    virtualAVR.advanceMicros(ms*1000);
+
+}
+
+void delayMicroseconds(uint16_t us) {
+
+    virtualAVR.advanceMicros(us);
+
+}
+
+
+//math
+
+long map(long x, long in_min, long in_max, long out_min, long out_max)  {
+
+    //computation isn't timed otherwise, but long division is too slow to ignore
+    virtualAVR.advance(CYCLES_MAP);
+
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+
+}
+
+
+//ADC
+
+void setADCprescaler(uint8_t prescaler) {
+
+    //ADPS bits hold exponent of prescaler, ADC is enabled along with it
+    uint8_t adps = 1;
+
+    while ((adps < 7) && ((1 << adps) < prescaler))  adps++;
+
+    ADCSRA = (ADCSRA & ~0x07) | (1 << ADEN) | adps;
+
+}
+
+void set8bitADC()   {
+
+    //8-bit result is read from left adjusted ADCH
+    ADMUX |= (1 << ADLAR);
+
+}
+
+void set10bitADC()  {
+
+    ADMUX &= ~(1 << ADLAR);
+
+}
+
+void setADCchannel(uint8_t adcChannel)  {
+
+    ADMUX = (ADMUX & 0xF0) | (adcChannel & 0x0F);
+
+}
+
+int16_t getADCvalue()   {
+
+    ADCSRA |= (1 << ADSC);
+    while (ADCSRA & (1 << ADSC));
+
+    if (ADMUX & (1 << ADLAR))   return ADCH;
+
+    uint8_t low = ADCL;
+    return (ADCH << 8) | low;
+
+}
+
+int16_t analogRead(uint8_t adcChannel)  {
+
+    setADCchannel(adcChannel);
+    return getADCvalue();
+
+}
+
+void disconnectDigitalInADC(uint8_t adcChannel) {
+
+    if (adcChannel < 6) DIDR0 |= (1 << adcChannel);
+
+}
+
+
+//serial
+
+void HardwareSerial::begin(uint32_t baudRate)   {
+
+    virtualAVR.serialBegin(baudRate);
+
+}
+
+int16_t HardwareSerial::available() {
+
+    return virtualAVR.serialAvailable();
+
+}
+
+int16_t HardwareSerial::peek()  {
+
+    return virtualAVR.serialPeek();
+
+}
+
+int16_t HardwareSerial::read()  {
+
+    return virtualAVR.serialRead();
+
+}
+
+void HardwareSerial::flush()    {
+
+    virtualAVR.serialFlush();
+
+}
+
+size_t HardwareSerial::write(uint8_t value) {
+
+    virtualAVR.serialWrite(value);
+    return 1;
+
+}
@@ -0,0 +1,67 @@
+/*
+
+OpenDECK host simulator v1.3
+File: Ownduino.h
+Last revision date: 2014-12-25
+Author: Igor Petrovic
+
+Host replacement for Ownduino core. Only the parts used by
+OpenDeck firmware are provided, all of them routed to virtual AVR.
+
+*/
+
+
+#ifndef HOST_OWNDUINO_H_
+#define HOST_OWNDUINO_H_
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "VirtualAVR.h"
+
+inline bool bitRead(uint32_t value, uint8_t bit)  {
+
+    virtualAVR.advance(CYCLES_BIT_ACCESS);
+    return (value >> bit) & 0x01;
+
+}
+
+#define bitSet(value, bit)              ((value) |= (1UL << (bit)))
+#define bitClear(value, bit)            ((value) &= ~(1UL << (bit)))
+#define bitWrite(value, bit, bitvalue)  (virtualAVR.advance(CYCLES_BIT_ACCESS), (bitvalue) ? bitSet(value, bit) : bitClear(value, bit))
+
+//time
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t);
+void delayMicroseconds(uint16_t);
+
+//math
+long map(long, long, long, long, long);
+
+//ADC
+void setADCprescaler(uint8_t);
+void set8bitADC();
+void set10bitADC();
+void setADCchannel(uint8_t);
+int16_t getADCvalue();
+int16_t analogRead(uint8_t);
+void disconnectDigitalInADC(uint8_t);
+
+class HardwareSerial    {
+
+    public:
+
+    void begin(uint32_t);
+    int16_t available();
+    int16_t peek();
+    int16_t read();
+    void flush();
+    size_t write(uint8_t);
+
+};
+
+extern HardwareSerial Serial;
+
+#endif /* HOST_OWNDUINO_H_ */
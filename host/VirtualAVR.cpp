@@ -0,0 +1,860 @@
+/*
+
+OpenDECK host simulator v1.3
+File: VirtualAVR.cpp
+Last revision date: 2014-12-25
+Author: Igor Petrovic
+
+*/
+
+#include "VirtualAVR.h"
+#include <avr/io.h>
+#include <string.h>
+#include "SysEx.h"
+
+//interrupt vectors are optional, firmware defines the ones it uses
+extern "C" void TIMER2_COMPA_vect(void) __attribute__((weak));
+extern "C" void USART_TX_vect(void) __attribute__((weak));
+extern "C" void ADC_vect(void) __attribute__((weak));
+
+static uint8_t readPortB(uint8_t)   { return virtualAVR.readPinB(PORTB.get()); }
+static uint8_t readPortD(uint8_t)   { return virtualAVR.readPinD(PORTD.get()); }
+static uint8_t readPortC(uint8_t)   { return PORTC.get(); }
+static void timerWrite(uint8_t)     { virtualAVR.timerConfigChanged(); }
+static void uartDataWrite(uint8_t value)    { virtualAVR.uartTransmit(value); }
+static uint8_t uartStatusRead(uint8_t value)    { return virtualAVR.uartStatus(value); }
+static void uartStatusWrite(uint8_t value)      { virtualAVR.uartStatusWritten(value); }
+static uint8_t adcStatusRead(uint8_t value)     { return virtualAVR.adcStatus(value); }
+static void adcControlWrite(uint8_t value)      { virtualAVR.adcControlWritten(value); }
+
+VirtualRegister PORTB, PORTC, PORTD;
+VirtualRegister DDRB, DDRC, DDRD;
+VirtualRegister PINB(readPortB), PINC(readPortC), PIND(readPortD);
+VirtualRegister TCCR2A(NULL, timerWrite), TCCR2B(NULL, timerWrite), TCNT2, OCR2A(NULL, timerWrite), TIMSK2(NULL, timerWrite);
+VirtualRegister DIDR0, ADMUX, ADCSRA(adcStatusRead, adcControlWrite), ADCL, ADCH;
+VirtualRegister UDR0(NULL, uartDataWrite), UCSR0A(uartStatusRead, uartStatusWrite), UCSR0B;
+
+VirtualAVR virtualAVR;
+
+
+VirtualRegister::VirtualRegister(uint8_t (*readHook)(uint8_t), void (*writeHook)(uint8_t))   {
+
+    value = 0;
+    readHandler = readHook;
+    writeHandler = writeHook;
+
+}
+
+VirtualRegister::operator uint8_t() {
+
+    virtualAVR.advance(CYCLES_REGISTER_ACCESS);
+
+    if (readHandler != NULL)    return readHandler(value);
+    return value;
+
+}
+
+VirtualRegister& VirtualRegister::operator=(uint8_t newValue)   {
+
+    virtualAVR.advance(CYCLES_REGISTER_ACCESS);
+
+    value = newValue;
+    if (writeHandler != NULL)   writeHandler(value);
+
+    return *this;
+
+}
+
+VirtualRegister& VirtualRegister::operator|=(uint8_t mask)  {
+
+    return (*this = (uint8_t)(get() | mask));
+
+}
+
+VirtualRegister& VirtualRegister::operator&=(uint8_t mask)  {
+
+    return (*this = (uint8_t)(get() & mask));
+
+}
+
+VirtualRegister& VirtualRegister::operator^=(uint8_t mask)  {
+
+    return (*this = (uint8_t)(get() ^ mask));
+
+}
+
+uint8_t VirtualRegister::get()  {
+
+    return value;
+
+}
+
+void VirtualRegister::set(uint8_t newValue) {
+
+    value = newValue;
+
+}
+
+
+VirtualAVR::VirtualAVR()    {
+
+    reset();
+
+}
+
+void VirtualAVR::reset()    {
+
+    cycleCounter            = 0;
+    globalInterrupts        = true;
+    inInterrupt             = false;
+
+    timer2Armed             = false;
+    timer2NextCompare       = 0;
+
+    board                   = 0;
+    memset(buttonMatrix, 0, sizeof(buttonMatrix));
+
+    memset(analogue, 0, sizeof(analogue));
+    memset(adcSamples, 0, sizeof(adcSamples));
+    resetADCintervals();
+    adcEnabled              = false;
+    adcConverting           = false;
+    adcFirstConversion      = true;
+    adcComplete             = false;
+    adcSample               = 0;
+    adcConversionDone       = 0;
+    analogueSource          = NULL;
+
+    //erased EEPROM cells read as 0xFF
+    memset(eeprom, 0xFF, sizeof(eeprom));
+
+    serialBitTime           = 0;
+    rxWireHead              = 0;
+    rxWireTail              = 0;
+    rxNextArrival           = 0;
+    rxHead                  = 0;
+    rxTail                  = 0;
+    txHead                  = 0;
+    txTail                  = 0;
+    txNextDrain             = 0;
+    serialMonitor           = NULL;
+    uartShifting            = false;
+    uartDataFull            = false;
+    uartShiftValue          = 0;
+    uartDataValue           = 0;
+    uartShiftDone           = 0;
+    uartTxComplete          = false;
+
+    isrCount                = 0;
+    isrCycles               = 0;
+    isrCyclesMax            = 0;
+    timer2Lost              = 0;
+    adcConversions          = 0;
+    eepromWrites            = 0;
+    serialRxBytes           = 0;
+    serialRxOverruns        = 0;
+    serialReadBytes         = 0;
+    serialTxBytes           = 0;
+    serialTxBlockedCycles   = 0;
+    uartISRcount            = 0;
+    uartISRcycles           = 0;
+    adcISRcount             = 0;
+    adcISRcycles            = 0;
+    adcISRcyclesMax         = 0;
+
+    VirtualRegister *registers[] = {
+
+        &PORTB, &PORTC, &PORTD,
+        &DDRB, &DDRC, &DDRD,
+        &PINB, &PINC, &PIND,
+        &TCCR2A, &TCCR2B, &TCNT2, &OCR2A, &TIMSK2,
+        &DIDR0, &ADMUX, &ADCSRA, &ADCL, &ADCH,
+        &UDR0, &UCSR0A, &UCSR0B
+
+    };
+
+    for (uint8_t i=0; i<sizeof(registers)/sizeof(registers[0]); i++)
+        registers[i]->set(0);
+
+}
+
+
+//virtual time
+
+void VirtualAVR::advance(uint32_t cycles)   {
+
+    uint64_t target = cycleCounter + cycles;
+
+    //peripherals keep running while CPU waits, serve interrupts on time
+    while (true)    {
+
+        uint64_t next = target;
+
+        if (timer2Armed && interruptsEnabled() && (timer2NextCompare < next))   next = timer2NextCompare;
+        if (uartShifting && (uartShiftDone < next))                             next = uartShiftDone;
+        if (adcConverting && (adcConversionDone < next))                        next = adcConversionDone;
+
+        if (next == target) break;
+
+        if (next > cycleCounter)    cycleCounter = next;
+
+        updateSerial();
+        checkUART();
+        checkADC();
+        checkTimer2();
+
+    }
+
+    if (cycleCounter < target)  cycleCounter = target;
+
+    updateSerial();
+    checkUART();
+    checkADC();
+    checkTimer2();
+
+}
+
+void VirtualAVR::advanceMicros(uint32_t us) {
+
+    advance(us * (F_CPU / 1000000UL));
+
+}
+
+uint64_t VirtualAVR::getCycles()    {
+
+    return cycleCounter;
+
+}
+
+uint32_t VirtualAVR::getMillis()    {
+
+    return (uint32_t)(cycleCounter / (F_CPU / 1000UL));
+
+}
+
+uint32_t VirtualAVR::getMicros()    {
+
+    return (uint32_t)(cycleCounter / (F_CPU / 1000000UL));
+
+}
+
+
+//interrupts
+
+void VirtualAVR::disableInterrupts()    {
+
+    globalInterrupts = false;
+
+}
+
+void VirtualAVR::enableInterrupts() {
+
+    globalInterrupts = true;
+
+    //serve interrupts which became pending while interrupts were disabled
+    checkUART();
+    checkADC();
+    checkTimer2();
+
+}
+
+bool VirtualAVR::interruptsEnabled()    {
+
+    return globalInterrupts && !inInterrupt;
+
+}
+
+uint32_t VirtualAVR::getTimer2Period()  {
+
+    static const uint16_t prescaler[] = { 0, 1, 8, 32, 64, 128, 256, 1024 };
+
+    uint16_t clockSelect = prescaler[TCCR2B.get() & 0x07];
+    uint16_t top = 256;
+
+    //CTC mode clears counter on compare match
+    if (TCCR2A.get() & (1 << WGM21))    top = OCR2A.get() + 1;
+
+    return (uint32_t)clockSelect * top;
+
+}
+
+void VirtualAVR::timerConfigChanged()   {
+
+    bool running = (getTimer2Period() != 0) && (TIMSK2.get() & (1 << OCIE2A));
+
+    if (running && !timer2Armed)    timer2NextCompare = cycleCounter + getTimer2Period();
+    timer2Armed = running;
+
+}
+
+void VirtualAVR::checkTimer2()  {
+
+    //only one compare match can be pending, others are lost
+    while (timer2Armed && interruptsEnabled() && (cycleCounter >= timer2NextCompare))    {
+
+        uint32_t period = getTimer2Period();
+
+        timer2NextCompare += period;
+
+        if (timer2NextCompare <= cycleCounter)  {
+
+            uint64_t overdue = (cycleCounter - timer2NextCompare) / period + 1;
+
+            timer2Lost += overdue;
+            timer2NextCompare += overdue * period;
+
+        }
+
+        uint32_t duration = runISR(TIMER2_COMPA_vect);
+
+        isrCount++;
+        isrCycles += duration;
+        if (duration > isrCyclesMax)    isrCyclesMax = duration;
+
+    }
+
+}
+
+void VirtualAVR::checkUART()    {
+
+    //frame is out, data buffer goes to shift register right away
+    while (uartShifting && (cycleCounter >= uartShiftDone)) {
+
+        if (serialMonitor != NULL)  serialMonitor(uartShiftValue);
+        serialTxBytes++;
+
+        if (uartDataFull)   {
+
+            uartShiftValue = uartDataValue;
+            uartDataFull = false;
+            uartShiftDone += serialBitTime;
+
+        }   else    {
+
+            uartShifting = false;
+            uartTxComplete = true;
+
+        }
+
+    }
+
+    //transmit complete flag is cleared when interrupt is served
+    if (uartTxComplete && (UCSR0B.get() & (1 << TXCIE0)) && interruptsEnabled() && (USART_TX_vect != NULL))  {
+
+        uartTxComplete = false;
+
+        uint32_t duration = runISR(USART_TX_vect);
+
+        uartISRcount++;
+        uartISRcycles += duration;
+
+    }
+
+}
+
+void VirtualAVR::uartTransmit(uint8_t value)    {
+
+    if (!serialBitTime) return;
+
+    if (!uartShifting)  {
+
+        uartShiftValue = value;
+        uartShifting = true;
+        uartShiftDone = cycleCounter + serialBitTime;
+
+    }   else    {
+
+        //data written while buffer is full is lost, same as on real UART
+        uartDataValue = value;
+        uartDataFull = true;
+
+    }
+
+}
+
+uint8_t VirtualAVR::uartStatus(uint8_t value)   {
+
+    //status flags come from transmitter state
+    value &= ~((1 << TXC0) | (1 << UDRE0));
+
+    if (uartTxComplete) value |= (1 << TXC0);
+    if (!uartDataFull)  value |= (1 << UDRE0);
+
+    return value;
+
+}
+
+void VirtualAVR::uartStatusWritten(uint8_t value)   {
+
+    //writing one to TXC0 clears it
+    if (value & (1 << TXC0))    uartTxComplete = false;
+
+}
+
+uint32_t VirtualAVR::runISR(void (*vector)(void))   {
+
+    if (vector == NULL) return 0;
+
+    uint64_t start = cycleCounter;
+
+    inInterrupt = true;
+    cycleCounter += CYCLES_ISR_OVERHEAD;
+    vector();
+    inInterrupt = false;
+
+    return (uint32_t)(cycleCounter - start);
+
+}
+
+
+//board wiring
+
+void VirtualAVR::setBoard(uint8_t boardType)    {
+
+    board = boardType;
+
+}
+
+uint8_t VirtualAVR::getBoard()  {
+
+    return board;
+
+}
+
+void VirtualAVR::setButton(uint8_t column, uint8_t row, bool state) {
+
+    if ((column < VIRTUAL_NUMBER_OF_COLUMNS) && (row < VIRTUAL_NUMBER_OF_ROWS))
+        buttonMatrix[column][row] = state;
+
+}
+
+bool VirtualAVR::getButton(uint8_t column, uint8_t row) {
+
+    if ((column < VIRTUAL_NUMBER_OF_COLUMNS) && (row < VIRTUAL_NUMBER_OF_ROWS))
+        return buttonMatrix[column][row];
+
+    return false;
+
+}
+
+int8_t VirtualAVR::getSelectedColumn()  {
+
+    uint8_t portC = PORTC.get();
+    uint8_t portD = PORTD.get();
+
+    switch (board)  {
+
+        case SYS_EX_BOARD_TYPE_OPEN_DECK_1:
+        //74HC238 decoder inputs are wired in reverse order on PC5-PC3
+        return ((portC >> 5) & 0x01) | (((portC >> 4) & 0x01) << 1) | (((portC >> 3) & 0x01) << 2);
+
+        case SYS_EX_BOARD_TYPE_TANNIN:
+        case SYS_EX_BOARD_TYPE_TANNIN_MUX16:
+        //active column is pulled low on PD2-PD6
+        for (int i=0; i<5; i++)
+            if (!((portD >> (i+2)) & 0x01)) return i;
+        return -1;
+
+        default:
+        return -1;
+
+    }
+
+}
+
+uint8_t VirtualAVR::getActiveLEDrows()  {
+
+    switch (board)  {
+
+        case SYS_EX_BOARD_TYPE_OPEN_DECK_1:
+        return PORTB.get() & 0x0F;
+
+        case SYS_EX_BOARD_TYPE_TANNIN:
+        case SYS_EX_BOARD_TYPE_TANNIN_MUX16:
+        return (PORTB.get() >> 4) & 0x01;
+
+        default:
+        return 0;
+
+    }
+
+}
+
+uint8_t VirtualAVR::readPinB(uint8_t portB) {
+
+    uint8_t pins = portB;
+
+    if ((board == SYS_EX_BOARD_TYPE_TANNIN) || (board == SYS_EX_BOARD_TYPE_TANNIN_MUX16))  {
+
+        int8_t column = getSelectedColumn();
+
+        //button rows are on PB0-PB3, pressed button pulls row low
+        if (column >= 0)
+            for (int i=0; i<4; i++)
+                if (buttonMatrix[column][i])    pins &= ~(1 << i);
+
+    }
+
+    return pins;
+
+}
+
+uint8_t VirtualAVR::readPinD(uint8_t portD) {
+
+    uint8_t pins = portD;
+
+    if (board == SYS_EX_BOARD_TYPE_OPEN_DECK_1) {
+
+        int8_t column = getSelectedColumn();
+
+        //button rows are on PD4-PD7, pressed button pulls row low
+        if (column >= 0)
+            for (int i=0; i<4; i++)
+                if (buttonMatrix[column][i])    pins &= ~(1 << (i+4));
+
+    }
+
+    return pins;
+
+}
+
+
+//ADC
+
+void VirtualAVR::setAnalogue(uint8_t channel, uint8_t muxInput, uint16_t value) {
+
+    if ((channel < VIRTUAL_NUMBER_OF_ADC_CHANNELS) && (muxInput < VIRTUAL_NUMBER_OF_MUX_INPUTS))
+        analogue[channel][muxInput] = value & 0x3FF;
+
+}
+
+void VirtualAVR::setAnalogueSource(uint16_t (*fptr)(uint8_t, uint8_t))    {
+
+    //source is asked for input value on each conversion instead, so
+    //that noise changes between conversions and during start-up too
+    analogueSource = fptr;
+
+}
+
+uint8_t VirtualAVR::getSelectedMuxInput()   {
+
+    switch (board)  {
+
+        case SYS_EX_BOARD_TYPE_OPEN_DECK_1:
+        return PORTC.get() & 0x07;
+
+        case SYS_EX_BOARD_TYPE_TANNIN:
+        return (PORTC.get() >> 2) & 0x07;
+
+        case SYS_EX_BOARD_TYPE_TANNIN_MUX16:
+        return (PORTC.get() >> 2) & 0x0F;
+
+        default:
+        return 0;
+
+    }
+
+}
+
+uint32_t VirtualAVR::getADCsamples(uint8_t channel, uint8_t muxInput)   {
+
+    if ((channel < VIRTUAL_NUMBER_OF_ADC_CHANNELS) && (muxInput < VIRTUAL_NUMBER_OF_MUX_INPUTS))
+        return adcSamples[channel][muxInput];
+
+    return 0;
+
+}
+
+uint32_t VirtualAVR::getADCintervalMax(uint8_t channel, uint8_t muxInput)   {
+
+    //longest time in cycles between two conversions of the same input
+    if ((channel < VIRTUAL_NUMBER_OF_ADC_CHANNELS) && (muxInput < VIRTUAL_NUMBER_OF_MUX_INPUTS))
+        return adcIntervalMax[channel][muxInput];
+
+    return 0;
+
+}
+
+void VirtualAVR::resetADCintervals()    {
+
+    //intervals are measured again starting with next conversion of each input
+    memset(adcLastStart, 0, sizeof(adcLastStart));
+    memset(adcIntervalMax, 0, sizeof(adcIntervalMax));
+
+}
+
+uint8_t VirtualAVR::adcStatus(uint8_t value)    {
+
+    //ADSC reads as one while conversion is running
+    value &= ~((1 << ADSC) | (1 << ADIF));
+
+    if (adcConverting)  value |= (1 << ADSC);
+    if (adcComplete)    value |= (1 << ADIF);
+
+    return value;
+
+}
+
+void VirtualAVR::adcControlWritten(uint8_t value)   {
+
+    //ADSC and ADIF aren't stored, they come from converter state
+    ADCSRA.set(value & ~((1 << ADSC) | (1 << ADIF)));
+
+    //writing one to ADIF clears it
+    if (value & (1 << ADIF))    adcComplete = false;
+
+    if (!(value & (1 << ADEN))) {
+
+        //disabling ADC aborts conversion
+        adcEnabled = false;
+        adcConverting = false;
+        return;
+
+    }
+
+    //first conversion after enabling ADC initializes analogue circuitry
+    if (!adcEnabled)    adcFirstConversion = true;
+    adcEnabled = true;
+
+    if ((value & (1 << ADSC)) && !adcConverting)    {
+
+        //prescaler select 0 divides by 2 as well
+        uint16_t prescaler = 1 << ((value & 0x07) ? (value & 0x07) : 1);
+        uint8_t channel = ADMUX.get() & 0x07;
+        uint8_t muxInput = getSelectedMuxInput();
+
+        //input is sampled and held at start of conversion
+        adcSample = (analogueSource != NULL) ? (analogueSource(channel, muxInput) & 0x3FF) : analogue[channel][muxInput];
+        adcSamples[channel][muxInput]++;
+
+        if (adcLastStart[channel][muxInput] && ((cycleCounter - adcLastStart[channel][muxInput]) > adcIntervalMax[channel][muxInput]))
+            adcIntervalMax[channel][muxInput] = (uint32_t)(cycleCounter - adcLastStart[channel][muxInput]);
+
+        adcLastStart[channel][muxInput] = cycleCounter;
+        adcConversionDone = cycleCounter + (uint32_t)(adcFirstConversion ? CYCLES_ADC_FIRST_CONVERSION : CYCLES_ADC_CONVERSION) * prescaler;
+        adcFirstConversion = false;
+        adcConverting = true;
+
+    }
+
+}
+
+void VirtualAVR::checkADC() {
+
+    if (adcConverting && (cycleCounter >= adcConversionDone))   {
+
+        //result is stored left adjusted if ADLAR is set
+        if (ADMUX.get() & (1 << ADLAR)) {
+
+            ADCH.set(adcSample >> 2);
+            ADCL.set((adcSample & 0x03) << 6);
+
+        }   else    {
+
+            ADCH.set(adcSample >> 8);
+            ADCL.set(adcSample & 0xFF);
+
+        }
+
+        adcConverting = false;
+        adcComplete = true;
+        adcConversions++;
+
+    }
+
+    //conversion complete flag is cleared when interrupt is served
+    if (adcComplete && (ADCSRA.get() & (1 << ADIE)) && interruptsEnabled() && (ADC_vect != NULL))   {
+
+        adcComplete = false;
+
+        uint32_t duration = runISR(ADC_vect);
+
+        adcISRcount++;
+        adcISRcycles += duration;
+        if (duration > adcISRcyclesMax) adcISRcyclesMax = duration;
+
+    }
+
+}
+
+
+//EEPROM
+
+uint8_t VirtualAVR::eepromRead(uint16_t address)    {
+
+    advance(CYCLES_EEPROM_READ);
+
+    if (address < VIRTUAL_EEPROM_SIZE)  return eeprom[address];
+    return 0xFF;
+
+}
+
+void VirtualAVR::eepromWrite(uint16_t address, uint8_t value)   {
+
+    advance(CYCLES_EEPROM_WRITE);
+
+    if (address < VIRTUAL_EEPROM_SIZE)  {
+
+        eeprom[address] = value;
+        eepromWrites++;
+
+    }
+
+}
+
+void VirtualAVR::eepromLoad(const uint8_t *data, uint16_t size) {
+
+    if (size > VIRTUAL_EEPROM_SIZE) size = VIRTUAL_EEPROM_SIZE;
+    memcpy(eeprom, data, size);
+
+}
+
+
+//serial
+
+void VirtualAVR::serialBegin(uint32_t baudRate) {
+
+    //start bit, 8 data bits, stop bit
+    serialBitTime = (uint32_t)((F_CPU * 10) / baudRate);
+    rxNextArrival = cycleCounter + serialBitTime;
+    txNextDrain = cycleCounter + serialBitTime;
+
+}
+
+uint32_t VirtualAVR::getSerialBitTime() {
+
+    return serialBitTime;
+
+}
+
+void VirtualAVR::setSerialMonitor(void (*fptr)(uint8_t))   {
+
+    serialMonitor = fptr;
+
+}
+
+void VirtualAVR::serialInject(const uint8_t *data, uint16_t size)   {
+
+    //bytes are placed on wire and received at configured baud rate
+    for (int i=0; i<size; i++)  {
+
+        uint16_t next = (rxWireHead + 1) % VIRTUAL_SERIAL_WIRE_SIZE;
+
+        if (next == rxWireTail) return;
+
+        //wire was idle, first byte arrives one frame from now
+        if (rxWireHead == rxWireTail)   rxNextArrival = cycleCounter + serialBitTime;
+
+        rxWire[rxWireHead] = data[i];
+        rxWireHead = next;
+
+    }
+
+}
+
+uint16_t VirtualAVR::getSerialWirePending() {
+
+    return (rxWireHead - rxWireTail + VIRTUAL_SERIAL_WIRE_SIZE) % VIRTUAL_SERIAL_WIRE_SIZE;
+
+}
+
+void VirtualAVR::updateSerial() {
+
+    if (!serialBitTime) return;
+
+    //receive
+    while ((rxWireHead != rxWireTail) && (cycleCounter >= rxNextArrival))   {
+
+        uint8_t next = (rxHead + 1) % VIRTUAL_SERIAL_BUFFER_SIZE;
+
+        if (next != rxTail) {
+
+            rxBuffer[rxHead] = rxWire[rxWireTail];
+            rxHead = next;
+            serialRxBytes++;
+
+        }   else serialRxOverruns++;
+
+        rxWireTail = (rxWireTail + 1) % VIRTUAL_SERIAL_WIRE_SIZE;
+        rxNextArrival += serialBitTime;
+
+    }
+
+    //transmit
+    while ((txHead != txTail) && (cycleCounter >= txNextDrain)) {
+
+        if (serialMonitor != NULL)  serialMonitor(txBuffer[txTail]);
+
+        txTail = (txTail + 1) % VIRTUAL_SERIAL_BUFFER_SIZE;
+        txNextDrain += serialBitTime;
+        serialTxBytes++;
+
+    }
+
+    if (txHead == txTail)   txNextDrain = cycleCounter + serialBitTime;
+
+}
+
+int16_t VirtualAVR::serialAvailable()   {
+
+    advance(CYCLES_SERIAL_ACCESS);
+    return (rxHead - rxTail + VIRTUAL_SERIAL_BUFFER_SIZE) % VIRTUAL_SERIAL_BUFFER_SIZE;
+
+}
+
+int16_t VirtualAVR::serialPeek()    {
+
+    advance(CYCLES_SERIAL_ACCESS);
+
+    if (rxHead == rxTail)   return -1;
+    return rxBuffer[rxTail];
+
+}
+
+int16_t VirtualAVR::serialRead()    {
+
+    advance(CYCLES_SERIAL_ACCESS);
+
+    if (rxHead == rxTail)   return -1;
+
+    uint8_t value = rxBuffer[rxTail];
+    rxTail = (rxTail + 1) % VIRTUAL_SERIAL_BUFFER_SIZE;
+    serialReadBytes++;
+
+    return value;
+
+}
+
+void VirtualAVR::serialWrite(uint8_t value) {
+
+    advance(CYCLES_SERIAL_ACCESS);
+
+    uint8_t next = (txHead + 1) % VIRTUAL_SERIAL_BUFFER_SIZE;
+
+    //buffer is full, wait until UART sends next byte
+    while (next == txTail)  {
+
+        uint64_t blocked = (txNextDrain > cycleCounter) ? (txNextDrain - cycleCounter) : 0;
+
+        serialTxBlockedCycles += blocked;
+        advance((uint32_t)blocked);
+
+    }
+
+    txBuffer[txHead] = value;
+    txHead = next;
+
+}
+
+void VirtualAVR::serialFlush()  {
+
+    while (txHead != txTail)    {
+
+        uint64_t blocked = (txNextDrain > cycleCounter) ? (txNextDrain - cycleCounter) : 0;
+
+        serialTxBlockedCycles += blocked;
+        advance((uint32_t)blocked);
+
+    }
+
+}
@@ -0,0 +1,238 @@
+/*
+
+OpenDECK host simulator v1.3
+File: VirtualAVR.h
+Last revision date: 2014-12-25
+Author: Igor Petrovic
+
+*/
+
+
+#ifndef VIRTUALAVR_H_
+#define VIRTUALAVR_H_
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#ifndef F_CPU
+#define F_CPU                           16000000UL
+#endif
+
+//size of simulated EEPROM (ATmega328p)
+#define VIRTUAL_EEPROM_SIZE             1024
+
+//Arduino core uses 64-byte serial buffers
+#define VIRTUAL_SERIAL_BUFFER_SIZE      64
+#define VIRTUAL_SERIAL_WIRE_SIZE        4096
+
+#define VIRTUAL_NUMBER_OF_ADC_CHANNELS  8
+#define VIRTUAL_NUMBER_OF_MUX_INPUTS    16
+#define VIRTUAL_NUMBER_OF_COLUMNS       8
+#define VIRTUAL_NUMBER_OF_ROWS          8
+
+/*
+
+    Virtual time is measured in CPU cycles and it only moves forward when
+    firmware touches the hardware abstraction layer. Each access is charged
+    with a fixed number of cycles, which makes every run fully deterministic:
+    same firmware and same stimulus always produce same timing.
+
+*/
+
+#define CYCLES_REGISTER_ACCESS          2
+#define CYCLES_BIT_ACCESS               2
+#define CYCLES_EEPROM_READ              4
+#define CYCLES_EEPROM_WRITE             54400   //3.4 ms
+#define CYCLES_ISR_OVERHEAD             20      //vector jump, register push/pop and reti
+#define CYCLES_SERIAL_ACCESS            8
+#define CYCLES_MAP                      700     //32-bit multiply and signed division in libgcc
+#define CYCLES_ADC_CONVERSION           13      //in ADC clocks
+#define CYCLES_ADC_FIRST_CONVERSION     25      //in ADC clocks
+
+class VirtualRegister   {
+
+    public:
+
+    VirtualRegister(uint8_t (*readHook)(uint8_t) = NULL, void (*writeHook)(uint8_t) = NULL);
+
+    operator uint8_t();
+    VirtualRegister& operator=(uint8_t);
+    VirtualRegister& operator|=(uint8_t);
+    VirtualRegister& operator&=(uint8_t);
+    VirtualRegister& operator^=(uint8_t);
+
+    //direct access for simulator, doesn't consume virtual time
+    uint8_t get();
+    void set(uint8_t);
+
+    private:
+
+    VirtualRegister(const VirtualRegister&);
+    VirtualRegister& operator=(const VirtualRegister&);
+
+    uint8_t value;
+    uint8_t (*readHandler)(uint8_t);
+    void (*writeHandler)(uint8_t);
+
+};
+
+class VirtualAVR    {
+
+    public:
+
+    VirtualAVR();
+
+    //resets cycle counter, peripherals and stimulus
+    void reset();
+
+    //virtual time
+    void advance(uint32_t);
+    void advanceMicros(uint32_t);
+    uint64_t getCycles();
+    uint32_t getMillis();
+    uint32_t getMicros();
+
+    //interrupts
+    void disableInterrupts();
+    void enableInterrupts();
+    bool interruptsEnabled();
+    void timerConfigChanged();
+    uint32_t getTimer2Period();
+
+    //board wiring used to decode port values
+    void setBoard(uint8_t);
+    uint8_t getBoard();
+
+    //buttons
+    void setButton(uint8_t, uint8_t, bool);
+    bool getButton(uint8_t, uint8_t);
+    uint8_t readPinB(uint8_t);
+    uint8_t readPinD(uint8_t);
+    int8_t getSelectedColumn();
+    uint8_t getActiveLEDrows();
+
+    //ADC driven through ADMUX and ADCSRA
+    void setAnalogue(uint8_t, uint8_t, uint16_t);
+    void setAnalogueSource(uint16_t (*fptr)(uint8_t, uint8_t));
+    uint8_t getSelectedMuxInput();
+    uint32_t getADCsamples(uint8_t, uint8_t);
+    uint32_t getADCintervalMax(uint8_t, uint8_t);
+    void resetADCintervals();
+    uint8_t adcStatus(uint8_t);
+    void adcControlWritten(uint8_t);
+
+    //EEPROM
+    uint8_t eepromRead(uint16_t);
+    void eepromWrite(uint16_t, uint8_t);
+    void eepromLoad(const uint8_t*, uint16_t);
+
+    //serial
+    void serialBegin(uint32_t);
+    void serialInject(const uint8_t*, uint16_t);
+    void setSerialMonitor(void (*fptr)(uint8_t));
+    int16_t serialAvailable();
+    int16_t serialRead();
+    int16_t serialPeek();
+    void serialWrite(uint8_t);
+    void serialFlush();
+    uint32_t getSerialBitTime();
+    uint16_t getSerialWirePending();
+
+    //UART transmitter driven directly through UDR0
+    void uartTransmit(uint8_t);
+    uint8_t uartStatus(uint8_t);
+    void uartStatusWritten(uint8_t);
+
+    //statistics
+    uint32_t isrCount;
+    uint64_t isrCycles;
+    uint32_t isrCyclesMax;
+    uint32_t timer2Lost;
+    uint32_t adcConversions;
+    uint32_t eepromWrites;
+    uint32_t serialRxBytes;
+    uint32_t serialRxOverruns;
+    uint32_t serialReadBytes;
+    uint32_t serialTxBytes;
+    uint64_t serialTxBlockedCycles;
+    uint32_t uartISRcount;
+    uint64_t uartISRcycles;
+    uint32_t adcISRcount;
+    uint64_t adcISRcycles;
+    uint32_t adcISRcyclesMax;
+
+    private:
+
+    void updateSerial();
+    void checkTimer2();
+    void checkUART();
+    void checkADC();
+    uint32_t runISR(void (*)(void));
+
+    uint64_t        cycleCounter;
+    bool            globalInterrupts,
+                    inInterrupt;
+
+    //timer 2
+    bool            timer2Armed;
+    uint64_t        timer2NextCompare;
+
+    //board
+    uint8_t         board;
+    bool            buttonMatrix[VIRTUAL_NUMBER_OF_COLUMNS][VIRTUAL_NUMBER_OF_ROWS];
+
+    //ADC
+    uint16_t        analogue[VIRTUAL_NUMBER_OF_ADC_CHANNELS][VIRTUAL_NUMBER_OF_MUX_INPUTS];
+    uint32_t        adcSamples[VIRTUAL_NUMBER_OF_ADC_CHANNELS][VIRTUAL_NUMBER_OF_MUX_INPUTS];
+    uint64_t        adcLastStart[VIRTUAL_NUMBER_OF_ADC_CHANNELS][VIRTUAL_NUMBER_OF_MUX_INPUTS];
+    uint32_t        adcIntervalMax[VIRTUAL_NUMBER_OF_ADC_CHANNELS][VIRTUAL_NUMBER_OF_MUX_INPUTS];
+    bool            adcEnabled,
+                    adcConverting,
+                    adcFirstConversion,
+                    adcComplete;
+    uint16_t        adcSample;
+    uint16_t        (*analogueSource)(uint8_t, uint8_t);
+    uint64_t        adcConversionDone;
+
+    //EEPROM
+    uint8_t         eeprom[VIRTUAL_EEPROM_SIZE];
+
+    //serial
+    uint32_t        serialBitTime;
+
+    uint8_t         rxWire[VIRTUAL_SERIAL_WIRE_SIZE];
+    uint16_t        rxWireHead,
+                    rxWireTail;
+    uint64_t        rxNextArrival;
+
+    uint8_t         rxBuffer[VIRTUAL_SERIAL_BUFFER_SIZE];
+    uint8_t         rxHead,
+                    rxTail;
+
+    uint8_t         txBuffer[VIRTUAL_SERIAL_BUFFER_SIZE];
+    uint8_t         txHead,
+                    txTail;
+    uint64_t        txNextDrain;
+    void            (*serialMonitor)(uint8_t);
+
+    //UART shift register and transmit data buffer
+    bool            uartShifting,
+                    uartDataFull,
+                    uartTxComplete;
+    uint8_t         uartShiftValue,
+                    uartDataValue;
+    uint64_t        uartShiftDone;
+
+};
+
+extern VirtualAVR virtualAVR;
+
+//simulated register file
+extern VirtualRegister  PORTB, PORTC, PORTD,
+                        DDRB, DDRC, DDRD,
+                        PINB, PINC, PIND,
+                        TCCR2A, TCCR2B, TCNT2, OCR2A, TIMSK2,
+                        DIDR0, ADMUX, ADCSRA, ADCL, ADCH,
+                        UDR0, UCSR0A, UCSR0B;
+
+#endif /* VIRTUALAVR_H_ */
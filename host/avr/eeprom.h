@@ -0,0 +1,39 @@
+/*
+
+OpenDECK host simulator v1.3
+File: avr/eeprom.h
+Last revision date: 2014-12-25
+Author: Igor Petrovic
+
+*/
+
+
+#ifndef HOST_AVR_EEPROM_H_
+#define HOST_AVR_EEPROM_H_
+
+#include <inttypes.h>
+#include <stdint.h>
+#include "VirtualAVR.h"
+
+//EEPROM is backed by RAM array inside virtual AVR
+
+inline uint8_t eeprom_read_byte(const uint8_t *address) {
+
+    return virtualAVR.eepromRead((uint16_t)(uintptr_t)address);
+
+}
+
+inline void eeprom_write_byte(uint8_t *address, uint8_t value)  {
+
+    virtualAVR.eepromWrite((uint16_t)(uintptr_t)address, value);
+
+}
+
+inline void eeprom_update_byte(uint8_t *address, uint8_t value) {
+
+    if (eeprom_read_byte(address) != value)
+        eeprom_write_byte(address, value);
+
+}
+
+#endif /* HOST_AVR_EEPROM_H_ */
@@ -0,0 +1,22 @@
+/*
+
+OpenDECK host simulator v1.3
+File: avr/interrupt.h
+Last revision date: 2014-12-25
+Author: Igor Petrovic
+
+*/
+
+
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#include "VirtualAVR.h"
+
+//interrupt vectors are plain functions called by virtual clock
+#define ISR(vector)     extern "C" void vector(void); extern "C" void vector(void)
+
+#define cli()           virtualAVR.disableInterrupts()
+#define sei()           virtualAVR.enableInterrupts()
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
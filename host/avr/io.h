@@ -0,0 +1,60 @@
+/*
+
+OpenDECK host simulator v1.3
+File: avr/io.h
+Last revision date: 2014-12-25
+Author: Igor Petrovic
+
+*/
+
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <inttypes.h>
+#include "VirtualAVR.h"
+
+//TCCR2A
+#define WGM20   0
+#define WGM21   1
+
+//TCCR2B
+#define CS20    0
+#define CS21    1
+#define CS22    2
+#define WGM22   3
+
+//TIMSK2
+#define TOIE2   0
+#define OCIE2A  1
+#define OCIE2B  2
+
+//ADMUX
+#define MUX0    0
+#define ADLAR   5
+#define REFS0   6
+#define REFS1   7
+
+//ADCSRA
+#define ADPS0   0
+#define ADPS1   1
+#define ADPS2   2
+#define ADIE    3
+#define ADIF    4
+#define ADATE   5
+#define ADSC    6
+#define ADEN    7
+
+//UCSR0A
+#define UDRE0   5
+#define TXC0    6
+#define RXC0    7
+
+//UCSR0B
+#define TXEN0   3
+#define RXEN0   4
+#define UDRIE0  5
+#define TXCIE0  6
+#define RXCIE0  7
+
+#endif /* HOST_AVR_IO_H_ */
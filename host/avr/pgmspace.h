@@ -0,0 +1,25 @@
+/*
+
+OpenDECK host simulator v1.3
+File: avr/pgmspace.h
+Last revision date: 2014-12-25
+Author: Igor Petrovic
+
+*/
+
+
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+#include <inttypes.h>
+#include <string.h>
+
+//there is only one address space on host
+#define PROGMEM
+
+#define pgm_read_byte(address)  (*(const uint8_t*)(address))
+#define pgm_read_word(address)  (*(const uint16_t*)(address))
+
+#define memcpy_P(dest, src, size)   memcpy(dest, src, size)
+
+#endif /* HOST_AVR_PGMSPACE_H_ */
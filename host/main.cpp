@@ -0,0 +1,1340 @@
+/*
+
+OpenDECK host simulator v1.3
+File: main.cpp
+Last revision date: 2014-12-25
+Author: Igor Petrovic
+
+Runs OpenDeck firmware on virtual AVR with scripted buttons, pots
+and incoming MIDI, and reports how much time hot paths take.
+
+*/
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Ownduino.h"
+#include "OpenDeck.h"
+#include "MIDI.h"
+
+//sketch
+void setup();
+
+typedef enum {
+
+    SCENARIO_IDLE,
+    SCENARIO_BUTTONS,
+    SCENARIO_POTS,
+    SCENARIO_MIDI,
+    SCENARIO_ALL,
+    SCENARIO_BOUNCE,
+    SCENARIO_LONG_PRESS,
+    SCENARIO_STATIC,
+    SCENARIO_PROGRAMS,
+    SCENARIO_PICKUP,
+    SCENARIO_ENCODERS,
+    SCENARIO_END
+
+} scenario;
+
+static const char *scenarioName[SCENARIO_END] = { "idle", "buttons", "pots", "midi", "all", "bounce", "longpress", "static", "programs", "pickup", "encoders" };
+
+typedef struct {
+
+    const char  *name;
+    uint32_t    calls;
+    uint64_t    hostTime,
+                hostTimeMax,
+                cycles;
+    uint32_t    cyclesMax;
+
+} stage;
+
+typedef enum {
+
+    STAGE_PROCESS_MATRIX,
+    STAGE_MIDI_READ,
+    STAGE_CHECK_RECEIVED_NOTE,
+    STAGE_READ_POTS,
+    STAGE_MIDI_UPDATE,
+    STAGE_END
+
+} stageIndex;
+
+static stage stages[STAGE_END] = {
+
+    { "OpenDeck::processMatrix",        0, 0, 0, 0, 0 },
+    { "MIDI_Class::read",               0, 0, 0, 0, 0 },
+    { "OpenDeck::checkReceivedNoteOn",  0, 0, 0, 0, 0 },
+    { "OpenDeck::readPots",             0, 0, 0, 0, 0 },
+    { "MIDI_Class::update",             0, 0, 0, 0, 0 }
+
+};
+
+static uint32_t txMessages[16];
+static uint8_t lastCCvalue[128];
+static uint32_t ccRedundant;
+static uint32_t randomState = 1;
+
+static uint64_t hostNanoseconds()   {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+
+}
+
+static uint16_t pseudoRandom()  {
+
+    //LCG keeps stimulus identical across runs
+    randomState = randomState * 1103515245 + 12345;
+    return (randomState >> 16) & 0x7FFF;
+
+}
+
+static uint32_t sysExResponses;
+static bool potsStimulated;
+static bool buttonPressPending, longPressPending;
+static uint64_t buttonPressTime, buttonNoteTime;
+static uint32_t longPressDelay, longPressDelayMin, longPressDelayMax, longPressCount;
+static uint16_t longPressTime;
+static uint32_t buttonLatencyMax, buttonLatencyCount, buttonPressesMissed;
+static uint64_t buttonLatency;
+static uint32_t startTime, ccStaleness, ccStalenessMax, ccStalenessCount;
+
+//pots selecting programs, time when each pot stopped at its target program
+static uint8_t potTargetProgram[16];
+static uint32_t potStopTime[16];
+static uint16_t programSettleTime;
+static uint32_t potStops, programsCrossed, programDelay, programDelayMax, programChanges, programsUnexpected;
+
+//values host sets for pots in pickup scenario, CC sent right after
+//target is set could have been generated before it was received
+#define PICKUP_GRACE_TIME 20
+
+static bool pickupPending[16];
+static uint8_t pickupTarget[16];
+static uint32_t pickupTime[16];
+static uint32_t pickupTargets, pickupsDone, pickupJumps, pickupDelay, pickupDelayMax;
+
+//encoders on button rows, turned back and forth over ENCODER_SWEEP_STEPS
+//quadrature steps, stimulus stops a while before end of run so that
+//last detent is out before report
+#define ENCODER_SWEEP_STEPS     (12*ENCODER_STEPS_PER_DETENT)
+#define ENCODER_SETTLE_TIME     50
+
+static uint16_t encoderPhase[MAX_NUMBER_OF_ENCODERS];
+static uint32_t encoderStep[MAX_NUMBER_OF_ENCODERS];
+static int32_t encoderDetentsTurned[MAX_NUMBER_OF_ENCODERS], encoderDetentsReceived[MAX_NUMBER_OF_ENCODERS];
+static uint32_t encoderDetents, encoderCCs, encoderCCsUnexpected;
+static uint8_t encoderColumns;
+static double encoderRate;
+
+//recorded pot readings, one line per millisecond
+static uint16_t *trace;
+static uint32_t traceLines;
+
+static uint16_t potStimulus(uint8_t potNumber, uint32_t time)   {
+
+    //triangle sweep with 2 s period, each pot is shifted by 125 ms
+    uint32_t phase = (time + potNumber*125) % 2000;
+    return (phase < 1000) ? (phase*1023/1000) : ((2000-phase)*1023/1000);
+
+}
+
+static void checkCCstaleness(uint8_t number, uint8_t value) {
+
+    //CC number equals pot number in default and uploaded configuration
+    if (!potsStimulated || (number >= MAX_NUMBER_OF_POTS))  return;
+
+    //find how long ago pot was at position which is sent now (CC value
+    //covers 8 ADC steps, stimulus noise is +/- 2 steps)
+    uint32_t time = virtualAVR.getMillis() - startTime;
+
+    for (uint32_t age=0; (age<=time) && (age<2000); age++)   {
+
+        int16_t position = potStimulus(number, time-age);
+
+        if ((position >= value*8-2) && (position <= value*8+9))    {
+
+            ccStaleness += age;
+            ccStalenessCount++;
+            if (age > ccStalenessMax)   ccStalenessMax = age;
+            return;
+
+        }
+
+    }
+
+}
+
+static void checkProgramChange(uint8_t program)    {
+
+    //each pot stops on its own programs, see stimulateProgramPots
+    uint8_t potNumber = (program < 64) ? (program / 4) : ((127 - program) / 4);
+    uint32_t time = virtualAVR.getMillis() - startTime;
+
+    if ((potNumber >= 16) || (potTargetProgram[potNumber] != program) || !potStopTime[potNumber])  {
+
+        programsUnexpected++;
+        return;
+
+    }
+
+    uint32_t delay = time - potStopTime[potNumber];
+
+    programDelay += delay;
+    if (delay > programDelayMax)    programDelayMax = delay;
+    programChanges++;
+
+}
+
+static void checkPickup(uint8_t number, uint8_t value)  {
+
+    if ((number >= 16) || !pickupPending[number])   return;
+
+    uint32_t delay = virtualAVR.getMillis() - startTime - pickupTime[number];
+
+    if (delay < PICKUP_GRACE_TIME)  return;
+
+    //pot is read every millisecond or so, it can't get far past target before it's sent
+    if (abs(value - pickupTarget[number]) > 2)  {
+
+        pickupJumps++;
+
+    }   else    {
+
+        pickupsDone++;
+        pickupDelay += delay;
+        if (delay > pickupDelayMax) pickupDelayMax = delay;
+
+    }
+
+    pickupPending[number] = false;
+
+}
+
+static void checkEncoderCC(uint8_t channel, uint8_t number, uint8_t value)  {
+
+    if (!encoderRate)   return;
+
+    //CC number is note of button on A input, notes are button numbers by default
+    uint8_t columns = encoderColumns;
+    uint8_t row = number / columns;
+
+    encoderCCs++;
+
+    if (channel || (row & 0x01) || ((value != 63) && (value != 65)))  {
+
+        encoderCCsUnexpected++;
+        return;
+
+    }
+
+    uint8_t encoderPair = number % columns + (row/2)*columns;
+
+    if (encoderPair >= MAX_NUMBER_OF_ENCODERS)  {
+
+        encoderCCsUnexpected++;
+        return;
+
+    }
+
+    encoderDetentsReceived[encoderPair] += (value == 65) ? 1 : -1;
+
+}
+
+static void countTxByte(uint8_t value)  {
+
+    //channel messages are counted once all data bytes are out,
+    //so that messages sent with running status are counted too
+    static uint8_t status, dataBytes, lastData;
+
+    if (value >= 0xF8)  return;
+
+    if (value & 0x80)   {
+
+        status = (value < 0xF0) ? value : 0;
+        dataBytes = 0;
+
+        if (value == 0xF0)  txMessages[0xF]++;
+        if (value == 0xF7)  sysExResponses++;
+
+        return;
+
+    }
+
+    if (!status)    return;
+
+    uint8_t type = status >> 4;
+
+    if (++dataBytes == (((type == 0xC) || (type == 0xD)) ? 1 : 2))  {
+
+        txMessages[type]++;
+        dataBytes = 0;
+
+        if (type == 0xC)    checkProgramChange(value);
+
+        if (type == 0xB)    {
+
+            checkEncoderCC(status & 0x0F, lastData, value);
+            checkCCstaleness(lastData, value);
+            checkPickup(lastData, value);
+
+            //same value as last time for this controller carries no information
+            if (lastCCvalue[lastData] == value) ccRedundant++;
+            lastCCvalue[lastData] = value;
+
+        }
+
+        //button notes use channel 1, pot notes channel 3
+        if (buttonPressPending && ((type == 0x8) || (type == 0x9)) && !(status & 0x0F))   {
+
+            uint32_t latency = (uint32_t)((virtualAVR.getCycles() - buttonPressTime) / (F_CPU/1000000UL));
+
+            buttonLatency += latency;
+            buttonLatencyCount++;
+            if (latency > buttonLatencyMax) buttonLatencyMax = latency;
+            buttonPressPending = false;
+
+            buttonNoteTime = virtualAVR.getCycles();
+            longPressPending = true;
+
+        }
+
+        //long-press note goes to channel 2, delay is measured from regular note
+        if (longPressPending && (type == 0x9) && ((status & 0x0F) == 1) && value)  {
+
+            uint32_t delay = (uint32_t)((virtualAVR.getCycles() - buttonNoteTime) / (F_CPU/1000000UL));
+
+            longPressDelay += delay;
+            if (!longPressCount || (delay < longPressDelayMin)) longPressDelayMin = delay;
+            if (delay > longPressDelayMax)  longPressDelayMax = delay;
+            longPressCount++;
+            longPressPending = false;
+
+        }
+
+    }   else    {
+
+        lastData = value;
+
+    }
+
+}
+
+static void timeStage(stageIndex index, void (*function)())  {
+
+    uint64_t hostStart = hostNanoseconds();
+    uint64_t cycleStart = virtualAVR.getCycles();
+    uint64_t isrStart = virtualAVR.isrCycles + virtualAVR.uartISRcycles + virtualAVR.adcISRcycles;
+
+    function();
+
+    uint64_t hostTime = hostNanoseconds() - hostStart;
+    //ISR time isn't attributed to function which got interrupted
+    uint32_t cycles = (uint32_t)((virtualAVR.getCycles() - cycleStart) - (virtualAVR.isrCycles + virtualAVR.uartISRcycles + virtualAVR.adcISRcycles - isrStart));
+
+    stages[index].calls++;
+    stages[index].hostTime += hostTime;
+    stages[index].cycles += cycles;
+    if (hostTime > stages[index].hostTimeMax)   stages[index].hostTimeMax = hostTime;
+    if (cycles > stages[index].cyclesMax)       stages[index].cyclesMax = cycles;
+
+}
+
+static void processMatrix()         { openDeck.processMatrix(); }
+static void readMIDI()              { MIDI.read(); }
+static void checkReceivedNoteOn()   { openDeck.checkReceivedNoteOn(); }
+static void readPots()              { openDeck.readPots(); }
+static void updateMIDI()            { MIDI.update(); }
+
+static void runLoop()   {
+
+    //same order as loop() in OpenDeck.cpp
+    timeStage(STAGE_PROCESS_MATRIX, processMatrix);
+    timeStage(STAGE_MIDI_READ, readMIDI);
+    timeStage(STAGE_CHECK_RECEIVED_NOTE, checkReceivedNoteOn);
+    timeStage(STAGE_READ_POTS, readPots);
+    timeStage(STAGE_MIDI_UPDATE, updateMIDI);
+
+}
+
+
+//stimulus
+
+static uint8_t boardColumns(uint8_t board)  {
+
+    return (board == SYS_EX_BOARD_TYPE_OPEN_DECK_1) ? 8 : 5;
+
+}
+
+static uint8_t boardLEDrows(uint8_t board)  {
+
+    return (board == SYS_EX_BOARD_TYPE_OPEN_DECK_1) ? 4 : 1;
+
+}
+
+static uint8_t boardMuxInputs(uint8_t board)    {
+
+    return (board == SYS_EX_BOARD_TYPE_TANNIN_MUX16) ? 16 : 8;
+
+}
+
+static uint8_t boardMuxes(uint8_t board)    {
+
+    return (board == SYS_EX_BOARD_TYPE_TANNIN_MUX16) ? 4 : 2;
+
+}
+
+static uint8_t boardPots(uint8_t board) {
+
+    //muxes which don't fit into MAX_NUMBER_OF_POTS aren't read, see OpenDeck::initBoard
+    uint8_t muxes = boardMuxes(board);
+
+    if (muxes*boardMuxInputs(board) > MAX_NUMBER_OF_POTS)   muxes = MAX_NUMBER_OF_POTS/boardMuxInputs(board);
+
+    return muxes*boardMuxInputs(board);
+
+}
+
+static uint8_t boardADCchannel(uint8_t board, uint8_t muxNumber)    {
+
+    //see OpenDeck::initBoard
+    if (board == SYS_EX_BOARD_TYPE_TANNIN)          return muxNumber;
+    if (board == SYS_EX_BOARD_TYPE_TANNIN_MUX16)    return (muxNumber < 2) ? muxNumber : muxNumber+4;
+    return muxNumber ? 6 : 7;
+
+}
+
+static uint8_t boardMuxNumber(uint8_t board, uint8_t adcChannel)    {
+
+    if (board == SYS_EX_BOARD_TYPE_TANNIN)          return adcChannel;
+    if (board == SYS_EX_BOARD_TYPE_TANNIN_MUX16)    return (adcChannel < 2) ? adcChannel : adcChannel-4;
+    return 7 - adcChannel;
+
+}
+
+#define MAX_UPLOAD_MESSAGES 12
+
+static uint8_t uploadMessage[MAX_UPLOAD_MESSAGES][MIDI_SYSEX_ARRAY_SIZE];
+static uint8_t uploadMessageLength[MAX_UPLOAD_MESSAGES];
+static uint8_t uploadMessages, uploadIndex;
+static uint32_t uploadBytes, uploadStart, uploadTime;
+
+static void stimulateButtons(uint8_t board, uint32_t time, uint32_t period, uint32_t hold, bool bounce)  {
+
+    //press one button every period and hold it for given time
+    uint8_t columns = boardColumns(board);
+    uint8_t activeButton = (time / period) % (columns*4);
+    uint8_t chatteringButton = 0xFF;
+    uint32_t phase = time % period;
+    bool pressed = (phase < hold);
+
+    if (bounce) {
+
+        //contacts bounce for 5 ms after press and release, and button
+        //in next row of the same column chatters while press is debounced
+        if ((phase < 5) || ((phase >= hold) && (phase < hold+5)))   pressed = pseudoRandom() & 0x01;
+
+        if ((phase >= 5) && (phase < 15))
+            chatteringButton = (activeButton + columns) % (columns*4);
+
+    }
+
+    //latency is measured from press until first button message is out,
+    //except while configuration upload keeps writing EEPROM
+    if (!phase && (uploadIndex == uploadMessages))  {
+
+        if (buttonPressPending) buttonPressesMissed++;
+
+        buttonPressTime = virtualAVR.getCycles();
+        buttonPressPending = true;
+        longPressPending = false;
+
+    }
+
+    for (int i=0; i<columns*4; i++)   {
+
+        if (i == chatteringButton)  virtualAVR.setButton(i % columns, i / columns, pseudoRandom() & 0x01);
+        else                        virtualAVR.setButton(i % columns, i / columns, pressed && (i == activeButton));
+
+    }
+
+}
+
+static uint8_t encoderPosition(uint32_t step)  {
+
+    uint32_t phase = step % (2*ENCODER_SWEEP_STEPS);
+    return (phase < ENCODER_SWEEP_STEPS) ? phase : (2*ENCODER_SWEEP_STEPS - phase);
+
+}
+
+static void stimulateEncoders(uint8_t board, uint32_t time)  {
+
+    /*
+
+        Every pair of button rows in every column is encoder, A on even
+        row and B on next one. Encoders step at given detent rate, each
+        shifted by random phase, and turn back after ENCODER_SWEEP_STEPS.
+        Encoder is sampled once per matrix frame, so one step per frame
+        (number of columns in ms) is the fastest it can be decoded.
+
+    */
+
+    static const uint8_t grayCode[4] = { 0x00, 0x02, 0x03, 0x01 };
+    uint8_t columns = boardColumns(board);
+    double stepsPerMs = encoderRate*ENCODER_STEPS_PER_DETENT/1000;
+
+    for (int i=0; i<columns*2; i++) {
+
+        if (!time)  encoderPhase[i] = pseudoRandom() % 1000;
+
+        //phase only shifts timing, every encoder starts at rest on step 0,
+        //small offset keeps exact rates from rounding a millisecond late
+        uint32_t step = (uint32_t)((time + encoderPhase[i])*stepsPerMs + 1e-6) - (uint32_t)(encoderPhase[i]*stepsPerMs + 1e-6);
+
+        //count completed detents, there can be more than one step at high rates
+        for (; encoderStep[i] < step; encoderStep[i]++)  {
+
+            uint8_t position = encoderPosition(encoderStep[i]+1);
+
+            if (position % ENCODER_STEPS_PER_DETENT)   continue;
+
+            encoderDetentsTurned[i] += (position > encoderPosition(encoderStep[i])) ? 1 : -1;
+            encoderDetents++;
+
+        }
+
+        uint8_t state = grayCode[encoderPosition(step) & 0x03];
+
+        virtualAVR.setButton(i % columns, (i / columns)*2, state & 0x01);
+        virtualAVR.setButton(i % columns, (i / columns)*2+1, (state >> 1) & 0x01);
+
+    }
+
+}
+
+static bool loadTrace(const char *fileName)    {
+
+    /*
+
+        Trace is a text file with one line per millisecond and up to 16
+        readings (0-1023) per line, first one for pot 0. Pots without
+        own reading get reading from first column, lines starting with
+        # are skipped. Trace is repeated if it's shorter than the run.
+
+    */
+
+    FILE *file = fopen(fileName, "r");
+    char line[256];
+    uint32_t allocated = 0;
+
+    if (!file)  return false;
+
+    while (fgets(line, sizeof(line), file))    {
+
+        uint16_t readings[16];
+        uint8_t count = 0;
+        char *position = line;
+
+        if (line[0] == '#') continue;
+
+        while (count < 16)  {
+
+            char *end;
+            long value = strtol(position, &end, 10);
+
+            if (end == position)    break;
+
+            readings[count++] = (value < 0) ? 0 : ((value > 1023) ? 1023 : value);
+            position = end;
+
+        }
+
+        if (!count) continue;
+
+        if (traceLines == allocated)    {
+
+            allocated = allocated ? allocated*2 : 1024;
+            trace = (uint16_t*)realloc(trace, allocated*16*sizeof(uint16_t));
+
+        }
+
+        for (int i=0; i<16; i++)    trace[traceLines*16+i] = readings[(i < count) ? i : 0];
+
+        traceLines++;
+
+    }
+
+    fclose(file);
+    return (traceLines != 0);
+
+}
+
+static uint16_t restingPot(uint8_t channel, uint8_t muxInput)    {
+
+    //pots at rest are spread over whole range, each with different
+    //amount of noise on every conversion, or replay recorded readings
+    uint8_t potNumber = boardMuxNumber(virtualAVR.getBoard(), channel)*boardMuxInputs(virtualAVR.getBoard()) + muxInput;
+
+    //only first 16 pots are held still
+    if (potNumber >= 16)    return 0;
+
+    if (traceLines) return trace[(virtualAVR.getMillis() % traceLines)*16 + potNumber];
+
+    //triangular noise of +/- 2, 5, 8 or 11 steps
+    uint8_t noise = 2 + (muxInput % 4)*3;
+    int16_t value = 64 + potNumber*60;
+
+    value += (pseudoRandom() % (noise+1)) + (pseudoRandom() % (noise+1)) - noise;
+    value += (int16_t)lround((muxInput % 4) * sin(2*M_PI*50*virtualAVR.getMicros()/1e6 + potNumber));
+
+    return (value < 0) ? 0 : value;
+
+}
+
+static void stimulatePots(uint8_t board, uint32_t time)  {
+
+    //triangle sweep with a bit of noise
+    for (int potNumber=0; potNumber<boardPots(board); potNumber++)  {
+
+        int16_t value = potStimulus(potNumber, time);
+
+        value += (pseudoRandom() % 5) - 2;
+
+        if (value < 0)      value = 0;
+        if (value > 1023)   value = 1023;
+
+        virtualAVR.setAnalogue(boardADCchannel(board, potNumber/boardMuxInputs(board)), potNumber%boardMuxInputs(board), value);
+
+    }
+
+}
+
+static void stimulateProgramPots(uint8_t board, uint32_t time)  {
+
+    /*
+
+        Every 2 s each pot sweeps for 400 ms and then rests on a program
+        which identifies it, low end on program 4*pot and high end on
+        127-4*pot, alternating. Pots are shifted by 125 ms.
+
+    */
+
+    for (int potNumber=0; potNumber<16; potNumber++)    {
+
+        uint32_t shifted = time + potNumber*125;
+        uint32_t phase = shifted % 2000;
+        bool up = (shifted / 2000) & 0x01;
+        uint8_t lowProgram = potNumber*4, highProgram = 127 - potNumber*4;
+        int16_t from = (up ? lowProgram : highProgram)*8+4;
+        int16_t to = (up ? highProgram : lowProgram)*8+4;
+        int16_t value = to;
+
+        if (phase < 400)    value = from + (int32_t)(to - from)*phase/400;
+
+        if (phase == 400)   {
+
+            potTargetProgram[potNumber] = up ? highProgram : lowProgram;
+            potStopTime[potNumber] = time;
+            potStops++;
+            programsCrossed += highProgram - lowProgram;
+
+        }
+
+        value += (pseudoRandom() % 5) - 2;
+
+        virtualAVR.setAnalogue(boardADCchannel(board, potNumber/boardMuxInputs(board)), potNumber%boardMuxInputs(board), value);
+
+    }
+
+}
+
+static void stimulatePickup(uint32_t time)  {
+
+    //every 10 s host recalls a preset and reports new value of every
+    //pot parameter, pots keep sweeping with 8 s period, slow enough
+    //not to fill MIDI output, so that CC isn't sent long after it's made
+    if ((time % 10000) != 500)  return;
+
+    uint8_t message[1+2*16];
+    uint8_t length = 0;
+
+    message[length++] = 0xB0 | (defConf[EEPROM_MC_POT_CC]-1);
+
+    for (int i=0; i<16; i++)    {
+
+        pickupTarget[i] = pseudoRandom() % 128;
+        pickupTime[i] = time;
+        pickupPending[i] = true;
+        pickupTargets++;
+
+        message[length++] = i;
+        message[length++] = pickupTarget[i];
+
+    }
+
+    virtualAVR.serialInject(message, length);
+
+}
+
+
+static bool ledBurstOn, ledSeenOn[MAX_NUMBER_OF_LEDS];
+static uint32_t ledBursts, ledBurstTime, ledChecks, ledMismatches;
+static double ledStormTime;
+
+static void addSysEx(const uint8_t *data, uint8_t size)  {
+
+    uint8_t *message = uploadMessage[uploadMessages];
+    uint8_t length = 0;
+
+    message[length++] = 0xF0;
+    message[length++] = SYS_EX_M_ID_0;
+    message[length++] = SYS_EX_M_ID_1;
+    message[length++] = SYS_EX_M_ID_2;
+
+    for (int i=0; i<size; i++)  message[length++] = data[i];
+
+    message[length++] = 0xF7;
+
+    uploadMessageLength[uploadMessages++] = length;
+    uploadBytes += length;
+
+}
+
+static void addSysExSetAll(uint8_t messageType, uint8_t messageSubType, const uint8_t *values, uint8_t size)    {
+
+    uint8_t data[MIDI_SYSEX_ARRAY_SIZE];
+
+    data[0] = SYS_EX_WISH_SET;
+    data[1] = SYS_EX_AMOUNT_ALL;
+    data[2] = messageType;
+    data[3] = messageSubType;
+
+    for (int i=0; i<size; i++)  data[4+i] = values[i];
+
+    addSysEx(data, size+4);
+
+}
+
+static void prepareUpload(uint8_t curve) {
+
+    uint8_t values[MAX_NUMBER_OF_BUTTONS];
+
+    //hello world
+    addSysEx(NULL, 0);
+
+    for (int i=0; i<MAX_NUMBER_OF_BUTTONS; i++) values[i] = i;
+    addSysExSetAll(SYS_EX_MT_BUTTON, SYS_EX_MST_BUTTON_NOTE, values, MAX_NUMBER_OF_BUTTONS);
+    addSysExSetAll(SYS_EX_MT_LED, SYS_EX_MST_LED_ACT_NOTE, values, MAX_NUMBER_OF_LEDS);
+    addSysExSetAll(SYS_EX_MT_POT, SYS_EX_MST_POT_CC_PP_NUMBER, values, MAX_NUMBER_OF_POTS);
+
+    for (int i=0; i<MAX_NUMBER_OF_BUTTONS; i++) values[i] = i & 0x01;
+    addSysExSetAll(SYS_EX_MT_BUTTON, SYS_EX_MST_BUTTON_TYPE, values, MAX_NUMBER_OF_BUTTONS);
+
+    for (int i=0; i<MAX_NUMBER_OF_POTS; i++)    values[i] = 0;
+    addSysExSetAll(SYS_EX_MT_POT, SYS_EX_MST_POT_LOWER_LIMIT, values, MAX_NUMBER_OF_POTS);
+
+    for (int i=0; i<MAX_NUMBER_OF_POTS; i++)    values[i] = 127;
+    addSysExSetAll(SYS_EX_MT_POT, SYS_EX_MST_POT_UPPER_LIMIT, values, MAX_NUMBER_OF_POTS);
+
+    for (int i=0; i<MAX_NUMBER_OF_POTS; i++)    values[i] = SYS_EX_POT_HYSTERESIS_AUTO;
+    addSysExSetAll(SYS_EX_MT_POT, SYS_EX_MST_POT_HW_P, values, MAX_NUMBER_OF_POTS);
+
+    //both user curves are linear, controller rebuilds their tables after the message
+    for (int i=0; i<SYS_EX_POT_USER_CURVES*SYS_EX_POT_USER_CURVE_POINTS; i++)
+        values[i] = ((i % SYS_EX_POT_USER_CURVE_POINTS)*127+7)/(SYS_EX_POT_USER_CURVE_POINTS-1);
+    addSysExSetAll(SYS_EX_MT_POT, SYS_EX_MST_POT_USER_CURVE_POINT, values, SYS_EX_POT_USER_CURVES*SYS_EX_POT_USER_CURVE_POINTS);
+
+    for (int i=0; i<MAX_NUMBER_OF_POTS; i++)    values[i] = curve;
+    addSysExSetAll(SYS_EX_MT_POT, SYS_EX_MST_POT_CURVE, values, MAX_NUMBER_OF_POTS);
+
+    //note zones stay at defaults
+    for (int i=0; i<SYS_EX_POT_NOTE_ZONE_LAYOUTS*SYS_EX_POT_NOTE_ZONES_MAX; i++)
+        values[i] = defConf[EEPROM_POT_NOTE_ZONE_START+i];
+    addSysExSetAll(SYS_EX_MT_POT, SYS_EX_MST_POT_NOTE_ZONE, values, SYS_EX_POT_NOTE_ZONE_LAYOUTS*SYS_EX_POT_NOTE_ZONES_MAX);
+
+    for (int i=0; i<MAX_NUMBER_OF_POTS; i++)    values[i] = 0;
+    addSysExSetAll(SYS_EX_MT_POT, SYS_EX_MST_POT_NOTE_ZONE_LAYOUT, values, MAX_NUMBER_OF_POTS);
+
+}
+
+static void stimulateMIDI(uint32_t time, uint8_t curve)    {
+
+    static uint32_t lastResponses = 0;
+
+    //configuration is uploaded first, next message is sent after controller responds
+    if (time == 0)  {
+
+        prepareUpload(curve);
+        uploadStart = time;
+        lastResponses = sysExResponses;
+        virtualAVR.serialInject(uploadMessage[0], uploadMessageLength[0]);
+
+    }   else if ((uploadIndex < uploadMessages) && (sysExResponses != lastResponses))   {
+
+        lastResponses = sysExResponses;
+
+        if (++uploadIndex < uploadMessages)
+            virtualAVR.serialInject(uploadMessage[uploadIndex], uploadMessageLength[uploadIndex]);
+        else uploadTime = time - uploadStart;
+
+    }
+
+    //burst of notes for all LEDs every 100 ms once configuration is sent
+    //bursts alternate between turning all LEDs on and off
+    if ((uploadIndex == uploadMessages) && ((time - ledBurstTime) >= 100))  {
+
+        uint8_t burst[1+2*MAX_NUMBER_OF_LEDS];
+        uint8_t length = 0;
+
+        //running status
+        burst[length++] = 0x90 | (openDeck.getInputMIDIchannel()-1);
+
+        for (int i=0; i<MAX_NUMBER_OF_LEDS; i++)    {
+
+            burst[length++] = i;
+            burst[length++] = ledBurstOn ? 0 : 32;
+
+        }
+
+        virtualAVR.serialInject(burst, length);
+        ledBurstOn = !ledBurstOn;
+        ledBursts++;
+        ledBurstTime = time;
+
+    }
+
+}
+
+static void observeLEDs(uint8_t board, uint32_t time)   {
+
+    static uint32_t lastCheck = (uint32_t)-1;
+
+    //LED rows are only visible while their column is selected, so
+    //physical state is collected during last 20 ms before next burst
+    if (!ledBursts || ((time - ledBurstTime) < 80)) return;
+
+    int8_t column = virtualAVR.getSelectedColumn();
+    uint8_t rows = virtualAVR.getActiveLEDrows();
+
+    if ((time - ledBurstTime) < 99)   {
+
+        if (column < 0) return;
+
+        for (int i=0; i<8; i++)
+            if ((rows >> i) & 0x01) ledSeenOn[column+i*boardColumns(board)] = true;
+
+        return;
+
+    }
+
+    if (time == lastCheck)  return;
+
+    lastCheck = time;
+
+    //compare with what last burst requested
+    for (int i=0; i<boardColumns(board)*boardLEDrows(board); i++)   {
+
+        if (ledSeenOn[i] != ledBurstOn) ledMismatches++;
+        ledSeenOn[i] = false;
+
+    }
+
+    ledChecks++;
+
+}
+
+static void benchmarkLEDnotes()  {
+
+    //virtual time doesn't see note to LED lookup, so notes for all LEDs
+    //are pushed directly through note handling and measured on host
+    const uint32_t storms = 10000;
+    uint8_t channel = openDeck.getInputMIDIchannel();
+    uint64_t hostStart = hostNanoseconds();
+
+    for (uint32_t i=0; i<storms; i++)   {
+
+        for (int j=0; j<MAX_NUMBER_OF_LEDS; j++)    {
+
+            openDeck.storeReceivedNoteOn(channel, j, (i & 0x01) ? 0 : 32);
+            if ((j % 16) == 15) openDeck.checkReceivedNoteOn();
+
+        }
+
+    }
+
+    ledStormTime = (double)(hostNanoseconds() - hostStart)/(storms*MAX_NUMBER_OF_LEDS);
+
+}
+
+static double benchmarkMatrixPasses(uint8_t board, bool busy)  {
+
+    const uint32_t passes = 100000;
+    uint8_t columns = boardColumns(board);
+    uint64_t hostStart = hostNanoseconds();
+
+    for (uint32_t i=0; i<passes; i++)   {
+
+        //busy matrix presses and releases all buttons every 50 row passes,
+        //rows are pulled low while pressed
+        uint8_t rows = (busy && ((i / (columns*50)) & 0x01)) ? 0x00 : 0x0F;
+
+        //feed column readings directly instead of waiting for ISR to capture frame
+        openDeck.readButtons(i % columns, rows);
+
+    }
+
+    return (double)(hostNanoseconds() - hostStart)/passes;
+
+}
+
+static void benchmarkMatrix(uint8_t board)  {
+
+    //virtual time doesn't see button processing, so column passes
+    //are run back to back and measured on host
+    //fastest of several runs filters out host scheduling noise
+    double idleTime = 0, busyTime = 0;
+
+    for (int i=0; i<5; i++) {
+
+        double time = benchmarkMatrixPasses(board, false);
+        if (!i || (time < idleTime))    idleTime = time;
+
+        time = benchmarkMatrixPasses(board, true);
+        if (!i || (time < busyTime))    busyTime = time;
+
+    }
+
+    printf("\nmatrix scan:            %.1f ns idle, %.1f ns busy per column\n", idleTime, busyTime);
+
+}
+
+
+static uint32_t benchmarkCCcount;
+
+static void benchmarkCC(uint8_t number, uint8_t value, uint8_t channel)   { benchmarkCCcount++; }
+static void benchmarkPotNote(uint8_t noteOff, uint8_t noteOffChannel, uint8_t noteOn, uint8_t noteOnChannel)  {}
+
+//friend of OpenDeck, readPotsMux is private
+void benchmarkPotReadings()  {
+
+    //readings are pushed directly through pot processing, MIDI
+    //output is replaced so that only processing is measured
+    const uint32_t sweeps = 20;
+    uint32_t readings = 0;
+    uint64_t cycles = 0;
+    uint64_t hostTime = 0;
+
+    openDeck.setHandlePotCC(benchmarkCC);
+    openDeck.setHandlePotNote(benchmarkPotNote);
+
+    uint8_t muxInputs = openDeck.getNumberOfMuxInputs();
+
+    for (uint32_t i=0; i<sweeps; i++)   {
+
+        for (int potNumber=0; potNumber<16; potNumber++)    {
+
+            //slow sweep up and down, 12-bit oversampled samples
+            for (int step=0; step<1024; step++) {
+
+                int16_t sample = ((step < 512) ? step : (1023-step)) * 8;
+                uint64_t isrStart = virtualAVR.isrCycles + virtualAVR.uartISRcycles + virtualAVR.adcISRcycles;
+                uint64_t cycleStart = virtualAVR.getCycles();
+                uint64_t hostStart = hostNanoseconds();
+
+                openDeck.readPotsMux(potNumber % muxInputs, potNumber / muxInputs, sample);
+
+                hostTime += hostNanoseconds() - hostStart;
+                cycles += (virtualAVR.getCycles() - cycleStart) - (virtualAVR.isrCycles + virtualAVR.uartISRcycles + virtualAVR.adcISRcycles - isrStart);
+                readings++;
+
+            }
+
+        }
+
+    }
+
+    printf("\npot readings:           %.1f cycles, %.1f ns per reading, %.1f%% sent CC\n",
+        (double)cycles/readings, (double)hostTime/readings, (double)benchmarkCCcount*100/readings);
+
+}
+
+
+//report
+
+static void printStage(stage &s)    {
+
+    if (!s.calls)   return;
+
+    printf("%-32s %10u %10.1f %10.1f %10.1f %10u\n", s.name, s.calls,
+        (double)s.hostTime/s.calls, (double)s.hostTimeMax,
+        (double)s.cycles/s.calls, s.cyclesMax);
+
+}
+
+static void printReport(uint8_t board, scenario test, uint32_t duration, uint32_t loops, uint64_t loopCycles, double loopCyclesSquared, uint32_t loopCyclesMax)   {
+
+    double loopAverage = loops ? (double)loopCycles/loops : 0.0;
+    double loopDeviation = loops ? sqrt(loopCyclesSquared/loops - loopAverage*loopAverage) : 0.0;
+
+    const char *boardName[] = { "OpenDeck reference board", "Tannin", "Tannin with 16-channel muxes" };
+
+    printf("board:                  %s, %u pots\n", boardName[board-SYS_EX_BOARD_TYPE_OPEN_DECK_1], boardPots(board));
+    printf("scenario:               %s\n", scenarioName[test]);
+    printf("virtual time:           %u ms\n", duration);
+    printf("loop iterations:        %u\n", loops);
+    printf("loop time:              %.1f us average, %.1f us deviation, %.1f us max\n",
+        loopAverage/(F_CPU/1000000UL), loopDeviation/(F_CPU/1000000UL), (double)loopCyclesMax/(F_CPU/1000000UL));
+    printf("TIMER2 ISR:             %u calls, %.1f cycles average, %u cycles max, %u lost\n",
+        virtualAVR.isrCount, virtualAVR.isrCount ? (double)virtualAVR.isrCycles/virtualAVR.isrCount : 0.0,
+        virtualAVR.isrCyclesMax, virtualAVR.timer2Lost);
+    printf("matrix frames:          %u captured, %u missed\n", openDeck.getFrameCounter(), openDeck.getMissedFrames());
+    printf("ADC conversions:        %u, ADC ISR %u calls, %.1f cycles average, %u cycles max\n", virtualAVR.adcConversions,
+        virtualAVR.adcISRcount, virtualAVR.adcISRcount ? (double)virtualAVR.adcISRcycles/virtualAVR.adcISRcount : 0.0,
+        virtualAVR.adcISRcyclesMax);
+
+    uint8_t pots = boardPots(board);
+    uint32_t potSamples = 0, potSamplesMin = 0, intervalMax = 0;
+    uint64_t intervals = 0;
+
+    for (int i=0; i<pots; i++)  {
+
+        uint8_t channel = boardADCchannel(board, i/boardMuxInputs(board));
+        uint32_t samples = virtualAVR.getADCsamples(channel, i%boardMuxInputs(board));
+        uint32_t interval = virtualAVR.getADCintervalMax(channel, i%boardMuxInputs(board));
+
+        potSamples += samples;
+        if (!i || (samples < potSamplesMin))    potSamplesMin = samples;
+
+        intervals += interval;
+        if (interval > intervalMax) intervalMax = interval;
+
+    }
+
+    printf("pot sampling:           %.0f conversions/s per pot average, %.0f min\n",
+        (double)potSamples*1000/pots/duration, (double)potSamplesMin*1000/duration);
+    printf("pot refresh interval:   %.2f ms worst case per pot average, %.2f ms max (floor %u Hz, %.2f ms)\n",
+        (double)intervals/pots/(F_CPU/1000UL), (double)intervalMax/(F_CPU/1000UL), POT_REFRESH_RATE_MIN, 1000.0/POT_REFRESH_RATE_MIN);
+    printf("EEPROM writes:          %u\n", virtualAVR.eepromWrites);
+    printf("serial in:              %u bytes, %u overruns, %u parsed (%.0f bytes/s)\n", virtualAVR.serialRxBytes,
+        virtualAVR.serialRxOverruns, virtualAVR.serialReadBytes, (double)virtualAVR.serialReadBytes*1000/duration);
+
+    if (uploadMessages)
+        printf("configuration upload:   %u bytes in %u messages, %s %u ms\n", uploadBytes, uploadMessages,
+            (uploadIndex == uploadMessages) ? "completed in" : "not completed after", (uploadIndex == uploadMessages) ? uploadTime : duration);
+
+    if (ledBursts)  {
+
+        printf("LED notes:              %u bursts, %u LEDs wrong in %u checks, %u notes dropped\n", ledBursts,
+            ledMismatches, ledChecks, openDeck.getReceivedNoteOverflow());
+        printf("LED note storm:         %.1f ns per note\n", ledStormTime);
+
+    }
+
+    printf("serial out:             %u bytes, blocked for %.1f ms\n", virtualAVR.serialTxBytes,
+        (double)virtualAVR.serialTxBlockedCycles/(F_CPU/1000UL));
+
+#if USE_TX_BUFFER
+    printf("TX buffer:              %u/%u bytes high water, %u messages dropped, %u UART ISR calls\n",
+        MIDI.getTxHighWater(), TX_BUFFER_SIZE-1, MIDI.getTxDropped(), virtualAVR.uartISRcount);
+#if CC_COALESCING_SLOTS
+    printf("CC coalescing:          %u values replaced before sending\n", MIDI.getCCcoalesced());
+#endif
+#endif
+    uint32_t messages = 0;
+
+    for (int i=0; i<16; i++)    messages += txMessages[i];
+
+    if (buttonLatencyCount)
+        printf("button latency:         %.2f ms average, %.2f ms max, %u presses missed (press to message out, includes debouncing)\n",
+            (double)buttonLatency/buttonLatencyCount/1000, (double)buttonLatencyMax/1000, buttonPressesMissed);
+
+    if (longPressCount)
+        printf("long-press delay:       %.2f ms average, %.2f ms min, %.2f ms max after press note (configured %u ms)\n",
+            (double)longPressDelay/longPressCount/1000, (double)longPressDelayMin/1000, (double)longPressDelayMax/1000,
+            longPressTime);
+
+    if (txMessages[0xB] && (test != SCENARIO_ENCODERS))
+        printf("CC messages:            %.2f per second per pot, %u redundant (same value as previous)\n",
+            (double)txMessages[0xB]*1000/pots/duration, ccRedundant);
+
+    if (test == SCENARIO_STATIC)
+        printf("messages at rest:       %.1f per minute per pot (%s)\n",
+            (double)(txMessages[0x8]+txMessages[0x9]+txMessages[0xB])*60000/16/duration, trace ? "recorded trace" : "generated noise");
+
+    if (test == SCENARIO_PROGRAMS)  {
+
+        printf("program changes:        %u sent for %u pot stops after crossing %u programs, %u unexpected\n",
+            programChanges, potStops, programsCrossed, programsUnexpected);
+        printf("program change delay:   %.1f ms average, %u ms max after pot stops (settle time %u ms)\n",
+            programChanges ? (double)programDelay/programChanges : 0.0, programDelayMax, programSettleTime);
+
+    }
+
+    if (test == SCENARIO_PICKUP)
+        printf("pickup:                 %u targets, %u picked up after %.1f ms average, %u ms max, %u jumps\n",
+            pickupTargets, pickupsDone, pickupsDone ? (double)pickupDelay/pickupsDone : 0.0, pickupDelayMax, pickupJumps);
+
+    if (test == SCENARIO_ENCODERS)  {
+
+        uint8_t pairs = boardColumns(board)*2;
+        uint32_t received = encoderCCs - encoderCCsUnexpected;
+        uint32_t offPosition = 0;
+
+        for (int i=0; i<pairs; i++)
+            if (encoderDetentsTurned[i] != encoderDetentsReceived[i])   offPosition++;
+
+        printf("encoders:               %u pairs at %.2f detents/s (max %.2f, one step per %u ms frame)\n",
+            pairs, encoderRate, 1000.0/(boardColumns(board)*ENCODER_STEPS_PER_DETENT), boardColumns(board));
+        printf("encoder detents:        %u turned, %u received, %d lost, %u unexpected CC, %u pairs off position\n",
+            encoderDetents, received, (int32_t)(encoderDetents - received), encoderCCsUnexpected, offPosition);
+
+    }
+
+    if (ccStalenessCount)
+        printf("CC staleness:           %.1f ms average, %u ms max\n", (double)ccStaleness/ccStalenessCount, ccStalenessMax);
+
+    printf("messages out:           %u note off, %u note on, %u CC, %u PC, %u SysEx, %.2f bytes per message\n",
+        txMessages[0x8], txMessages[0x9], txMessages[0xB], txMessages[0xC], txMessages[0xF],
+        messages ? (double)virtualAVR.serialTxBytes/messages : 0.0);
+
+    printf("\n%-32s %10s %10s %10s %10s %10s\n", "", "calls", "ns avg", "ns max", "cycles avg", "cycles max");
+
+    for (int i=0; i<STAGE_END; i++) printStage(stages[i]);
+
+}
+
+static void usage(const char *name) {
+
+    printf("usage: %s [-b board] [-t time] [-s scenario] [-r] [-l time] [-d hysteresis] [-a trace] [-c lower,upper] [-v curve] [-p time] [-e rate]\n", name);
+    #if FIXED_BOARD
+    printf("  -b board      %u only, firmware is built for fixed board\n", FIXED_BOARD);
+    #else
+    printf("  -b board      1 - OpenDeck reference board (default), 2 - Tannin, 3 - Tannin with 16-channel muxes\n");
+    #endif
+    printf("  -t time       virtual time to simulate in ms (default 10000)\n");
+    printf("  -s scenario   idle, buttons, pots, midi, all (default), bounce, longpress, static, programs, pickup or encoders\n");
+    printf("  -r            enable running status for outgoing messages\n");
+    printf("  -l time       long-press time in 100 ms steps (%u to %u)\n", SYS_EX_BUTTON_LONG_PRESS_TIME_MIN, SYS_EX_BUTTON_LONG_PRESS_TIME_MAX);
+    printf("  -d hysteresis pot hysteresis in ADC steps (1 to %u), 0 learns it from noise (default)\n", SYS_EX_POT_HYSTERESIS_MAX);
+    printf("  -a trace      feed pots from recorded readings in static scenario\n");
+    printf("  -c lower,upper CC limits of all pots (default 0,127)\n");
+    printf("  -v curve      response curve of all pots, 0 - linear (default), 1 - log, 2 - exp, 3 - S, 4/5 - user\n");
+    printf("  -p time       pot program change settle time in 10 ms steps (0 to %u)\n", SYS_EX_POT_PP_SETTLE_TIME_MAX);
+    printf("  -e rate       encoder detents per second in encoders scenario (default fastest decodable rate)\n");
+
+}
+
+int main(int argc, char *argv[])    {
+
+    #if FIXED_BOARD
+    uint8_t board = FIXED_BOARD;
+    #else
+    uint8_t board = SYS_EX_BOARD_TYPE_OPEN_DECK_1;
+    #endif
+    uint32_t duration = 10000;
+    scenario test = SCENARIO_ALL;
+    bool runningStatus = false;
+    uint8_t longPress = defConf[EEPROM_BUTTON_HW_P_LONG_PRESS_TIME];
+    int16_t hysteresis = SYS_EX_POT_HYSTERESIS_AUTO;
+    const char *traceFile = NULL;
+    int ccLower = 0, ccUpper = 127;
+    int16_t curve = SYS_EX_POT_CURVE_LINEAR;
+    int16_t settleTime = defConf[EEPROM_POT_PP_SETTLE_TIME_START];
+    double rate = 0;
+
+    for (int i=1; i<argc; i++)  {
+
+        if (!strcmp(argv[i], "-b") && (i+1 < argc))         board = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-t") && (i+1 < argc))    duration = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-r"))                    runningStatus = true;
+        else if (!strcmp(argv[i], "-l") && (i+1 < argc))    longPress = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-d") && (i+1 < argc))    hysteresis = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-a") && (i+1 < argc))    traceFile = argv[++i];
+        else if (!strcmp(argv[i], "-v") && (i+1 < argc))    curve = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-p") && (i+1 < argc))    settleTime = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-e") && (i+1 < argc))    {
+
+            //one step per millisecond is fastest stimulus can change
+            rate = atof(argv[++i]);
+            if ((rate <= 0) || (rate > 1000/ENCODER_STEPS_PER_DETENT))  { usage(argv[0]); return 1; }
+
+        }
+        else if (!strcmp(argv[i], "-c") && (i+1 < argc))    {
+
+            if (sscanf(argv[++i], "%d,%d", &ccLower, &ccUpper) != 2)   { usage(argv[0]); return 1; }
+
+        }
+        else if (!strcmp(argv[i], "-s") && (i+1 < argc))    {
+
+            const char *name = argv[++i];
+
+            for (test = SCENARIO_IDLE; test < SCENARIO_END; test = (scenario)(test+1))
+                if (!strcmp(name, scenarioName[test]))  break;
+
+            if (test == SCENARIO_END)   { usage(argv[0]); return 1; }
+
+        }   else { usage(argv[0]); return 1; }
+
+    }
+
+    if ((board <= SYS_EX_BOARD_TYPE_START) || (board >= SYS_EX_BOARD_TYPE_END)) { usage(argv[0]); return 1; }
+    #if FIXED_BOARD
+    //firmware can't run on other board
+    if (board != FIXED_BOARD)   { usage(argv[0]); return 1; }
+    #endif
+    if ((longPress < SYS_EX_BUTTON_LONG_PRESS_TIME_MIN) || (longPress > SYS_EX_BUTTON_LONG_PRESS_TIME_MAX))   { usage(argv[0]); return 1; }
+    if ((hysteresis < 0) || (hysteresis > SYS_EX_POT_HYSTERESIS_MAX))   { usage(argv[0]); return 1; }
+    if ((ccLower < 0) || (ccLower > 127) || (ccUpper < 0) || (ccUpper > 127))  { usage(argv[0]); return 1; }
+    if ((curve < SYS_EX_POT_CURVE_START) || (curve >= SYS_EX_POT_CURVE_END))   { usage(argv[0]); return 1; }
+    if ((settleTime < 0) || (settleTime > SYS_EX_POT_PP_SETTLE_TIME_MAX))  { usage(argv[0]); return 1; }
+
+    //encoders are only turned in encoders scenario
+    if (rate && (test != SCENARIO_ENCODERS))    { usage(argv[0]); return 1; }
+
+    if (traceFile)  {
+
+        //trace describes pots at rest only
+        if (test != SCENARIO_STATIC)    { usage(argv[0]); return 1; }
+
+        if (!loadTrace(traceFile))  {
+
+            printf("can't read trace %s\n", traceFile);
+            return 1;
+
+        }
+
+    }
+
+    //firmware clamps number of muxes it reads, results cover only pots which fit
+    if (boardPots(board) < boardMuxes(board)*boardMuxInputs(board))
+        printf("warning: board %d has %d pots, firmware built for %d pots reads only %d\n\n", board, boardMuxes(board)*boardMuxInputs(board), MAX_NUMBER_OF_POTS, boardPots(board));
+
+    //factory configuration with selected board and all pots enabled
+    uint8_t configuration[sizeof(defConf)];
+
+    memcpy(configuration, defConf, sizeof(defConf));
+    configuration[EEPROM_BOARD_TYPE] = board;
+    for (int i=0; i<MAX_NUMBER_OF_POTS/8; i++)
+        configuration[EEPROM_POT_ENABLED_START+i] = 0xFF;
+    if (runningStatus)  configuration[EEPROM_FEATURES_MIDI] |= (1 << SYS_EX_FEATURES_MIDI_RUNNING_STATUS);
+    configuration[EEPROM_BUTTON_HW_P_LONG_PRESS_TIME] = longPress;
+    longPressTime = longPress*100;
+
+    for (int i=0; i<MAX_NUMBER_OF_POTS; i++)    {
+
+        configuration[EEPROM_POT_HYSTERESIS_START+i] = hysteresis;
+        configuration[EEPROM_POT_LOWER_LIMIT_START+i] = ccLower;
+        configuration[EEPROM_POT_UPPER_LIMIT_START+i] = ccUpper;
+        configuration[EEPROM_POT_CURVE_START+i] = curve;
+        configuration[EEPROM_POT_PP_SETTLE_TIME_START+i] = settleTime;
+
+    }
+
+    if (test == SCENARIO_PICKUP)    configuration[EEPROM_FEATURES_POTS] |= (1 << SYS_EX_FEATURES_POTS_PICKUP);
+
+    //pots select programs instead of sending CC
+    if (test == SCENARIO_PROGRAMS)  {
+
+        configuration[EEPROM_POT_PP_ENABLED_START] = 0xFF;
+        configuration[EEPROM_POT_PP_ENABLED_START+1] = 0xFF;
+
+    }
+
+    //all pairs decode encoders, pots are disabled so that only encoders send CC
+    if (test == SCENARIO_ENCODERS)  {
+
+        //enable bits are stored inverted
+        for (int i=0; i<MAX_NUMBER_OF_ENCODERS/8; i++)
+            configuration[EEPROM_ENCODER_PAIR_ENABLED_START+i] = 0x00;
+
+        for (int i=0; i<MAX_NUMBER_OF_POTS/8; i++)
+            configuration[EEPROM_POT_ENABLED_START+i] = 0x00;
+
+        encoderColumns = boardColumns(board);
+        encoderRate = rate ? rate : 1000.0/(encoderColumns*ENCODER_STEPS_PER_DETENT);
+
+    }
+
+    programSettleTime = settleTime*10;
+
+    virtualAVR.reset();
+    virtualAVR.eepromLoad(configuration, sizeof(configuration));
+    virtualAVR.setBoard(board);
+    virtualAVR.setSerialMonitor(countTxByte);
+
+    //make sure pots don't send anything before stimulus starts
+    memset(lastCCvalue, 0xFF, sizeof(lastCCvalue));
+    if (test == SCENARIO_STATIC)        virtualAVR.setAnalogueSource(restingPot);
+    else if (test == SCENARIO_PROGRAMS) stimulateProgramPots(board, 0);
+    else                                stimulatePots(board, 0);
+    if (test == SCENARIO_ENCODERS)      stimulateEncoders(board, 0);
+
+    setup();
+
+    //pot refresh is measured once ADC interrupt samples pots on its own
+    virtualAVR.resetADCintervals();
+
+    uint32_t start = virtualAVR.getMillis();
+
+    startTime = start;
+    potsStimulated = ((test == SCENARIO_POTS) || (test == SCENARIO_ALL) || (test == SCENARIO_LONG_PRESS));
+    uint32_t lastStimulus = (uint32_t)-1;
+    uint32_t loops = 0;
+    uint64_t loopCycles = 0;
+    double loopCyclesSquared = 0;
+    uint32_t loopCyclesMax = 0;
+
+    while ((virtualAVR.getMillis() - start) < duration)   {
+
+        uint32_t time = virtualAVR.getMillis() - start;
+
+        //stimulus is updated once per virtual millisecond
+        if (time != lastStimulus)   {
+
+            if ((test == SCENARIO_BUTTONS) || (test == SCENARIO_ALL))   stimulateButtons(board, time, 100, 50, false);
+            if (test == SCENARIO_BOUNCE)                                stimulateButtons(board, time, 100, 50, true);
+            if (test == SCENARIO_LONG_PRESS)                            stimulateButtons(board, time, 2000, 1700, false);
+            if ((test == SCENARIO_POTS) || (test == SCENARIO_ALL) || (test == SCENARIO_LONG_PRESS))
+                stimulatePots(board, time);
+            if (test == SCENARIO_PICKUP)                                { stimulatePots(board, time/4); stimulatePickup(time); }
+            if (test == SCENARIO_PROGRAMS)                              stimulateProgramPots(board, time);
+            if ((test == SCENARIO_MIDI) || (test == SCENARIO_ALL))      stimulateMIDI(time, curve);
+            if (test == SCENARIO_ENCODERS)
+                stimulateEncoders(board, ((time + ENCODER_SETTLE_TIME) < duration) ? time : (duration - ENCODER_SETTLE_TIME));
+
+            lastStimulus = time;
+
+        }
+
+        uint64_t cycleStart = virtualAVR.getCycles();
+
+        runLoop();
+
+        uint32_t cycles = (uint32_t)(virtualAVR.getCycles() - cycleStart);
+
+        if ((test == SCENARIO_MIDI) || (test == SCENARIO_ALL))  observeLEDs(board, time);
+
+        loops++;
+        loopCycles += cycles;
+        loopCyclesSquared += (double)cycles*cycles;
+        if (cycles > loopCyclesMax) loopCyclesMax = cycles;
+
+    }
+
+    if (ledBursts)  benchmarkLEDnotes();
+
+    printReport(board, test, duration, loops, loopCycles, loopCyclesSquared, loopCyclesMax);
+
+    //button and pot processing is benchmarked after report since it sends messages too
+    if ((test == SCENARIO_BUTTONS) || (test == SCENARIO_BOUNCE) || (test == SCENARIO_ALL))  benchmarkMatrix(board);
+    if ((test == SCENARIO_POTS) || (test == SCENARIO_STATIC) || (test == SCENARIO_ALL))     benchmarkPotReadings();
+
+    return 0;
+
+}
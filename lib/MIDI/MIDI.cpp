@@ -35,6 +35,8 @@
 
 #include "MIDI.h"
 #include <stdlib.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
 #include "Ownduino.h"
 
 /*! \brief Main instance (the class comes pre-instantiated). */
@@ -60,13 +62,46 @@ MIDI_Class::MIDI_Class()    {
 
 #endif
 
+#if COMPILE_MIDI_OUT
+
+    mRunningStatusTXenabled     = false;
+    mRunningStatus_TX           = InvalidType;
+    mRunningStatusTXtime        = 0;
+
+#endif
+
+#if COMPILE_MIDI_OUT && USE_TX_BUFFER
+
+    mTxHead                     = 0;
+    mTxTail                     = 0;
+    mTxActive                   = false;
+    mTxHighWater                = 0;
+    mTxDropped                  = 0;
+    mTxQueued                   = 0;
+
+#if CC_COALESCING_SLOTS
+
+    mCCwaiting                  = 0;
+    mCCcoalesced                = 0;
+
+#endif
+
+#endif
+
 }
 
 
 /*! \brief Call the begin method in the setup() function of the Arduino.
+ \param inChannel          Input channel.
+ \param runningStatusTX    Enable running status for outgoing channel messages.
  */
-void MIDI_Class::begin(uint8_t inChannel)    {
+void MIDI_Class::begin(uint8_t inChannel, bool runningStatusTX)  {
 
+#if COMPILE_MIDI_OUT
+
+    setRunningStatusTX(runningStatusTX);
+
+#endif
 
 #if COMPILE_MIDI_IN
 
@@ -102,13 +137,15 @@ const byte MIDI_Class::genstatus(const kMIDIType inType,
  \param data1   The first data byte.
  \param data2   The second data byte (if the message contains only 1 data byte, set this one to 0).
  \param channel The output channel on which the message will be sent (values from 1 to 16). Note: you cannot send to OMNI.
+ \param priority MIDI_PRIORITY_HIGH goes to TX buffer right away, MIDI_PRIORITY_NORMAL waits until TX buffer is almost empty.
  
  This is an internal method, use it only if you need to send raw data from your code, at your own risks.
  */
 void MIDI_Class::send(kMIDIType type,
                       byte data1,
                       byte data2,
-                      byte channel) {
+                      byte channel,
+                      byte priority) {
 
     //Then test if channel is valid
     if (channel >= MIDI_CHANNEL_OFF || channel == MIDI_CHANNEL_OMNI || type < NoteOff) {
@@ -125,15 +162,13 @@ void MIDI_Class::send(kMIDIType type,
 
         byte statusbyte = genstatus(type,channel);
 
-        //Don't care about running status, send the Control byte.
-        USE_SERIAL_PORT.write(statusbyte);
-
-        // Then send data
-        USE_SERIAL_PORT.write(data1);
-        
-        if (type != ProgramChange && type != 0xD0)
-            USE_SERIAL_PORT.write(data2);
+#if USE_TX_BUFFER
+        //normal priority messages wait until TX buffer is almost empty
+        if ((priority == MIDI_PRIORITY_NORMAL) && txQueue(statusbyte, data1, data2))
+            return;
+#endif
 
+        sendChannelMessage(statusbyte, data1, data2);
         return;
     }
 
@@ -148,12 +183,14 @@ void MIDI_Class::send(kMIDIType type,
  \param NoteNumber  Pitch value in the MIDI format (0 to 127). Take a look at the values, names and frequencies of notes here: http://www.phys.unsw.edu.au/jw/notes.html\n
  \param Velocity    Note attack velocity (0 to 127). A NoteOn with 0 velocity is considered as a NoteOff.
  \param Channel     The channel on which the message will be sent (1 to 16). 
+ \param Priority    MIDI_PRIORITY_HIGH (default) or MIDI_PRIORITY_NORMAL.
  */
 void MIDI_Class::sendNoteOn(byte NoteNumber,
                             byte Velocity,
-                            byte Channel)   {
+                            byte Channel,
+                            byte Priority)  {
 
-    send(NoteOn, NoteNumber, Velocity, Channel);
+    send(NoteOn, NoteNumber, Velocity, Channel, Priority);
 
 }
 
@@ -162,12 +199,14 @@ void MIDI_Class::sendNoteOn(byte NoteNumber,
  \param NoteNumber  Pitch value in the MIDI format (0 to 127). Take a look at the values, names and frequencies of notes here: http://www.phys.unsw.edu.au/jw/notes.html\n
  \param Velocity    Release velocity (0 to 127).
  \param Channel     The channel on which the message will be sent (1 to 16).
+ \param Priority    MIDI_PRIORITY_HIGH (default) or MIDI_PRIORITY_NORMAL.
  */
 void MIDI_Class::sendNoteOff(byte NoteNumber,
                              byte Velocity,
-                             byte Channel)  {
+                             byte Channel,
+                             byte Priority) {
 
-    send(NoteOff, NoteNumber, Velocity, Channel);
+    send(NoteOff, NoteNumber, Velocity, Channel, Priority);
 
 }
 
@@ -177,22 +216,25 @@ void MIDI_Class::sendNoteOff(byte NoteNumber,
  \param ControlNumber   The controller number (0 to 127). See the detailed description here: http://www.somascape.org/midi/tech/spec.html#ctrlnums
  \param ControlValue    The value for the specified controller (0 to 127).
  \param Channel         The channel on which the message will be sent (1 to 16). 
+ \param Priority        MIDI_PRIORITY_NORMAL (default) or MIDI_PRIORITY_HIGH.
  */
 void MIDI_Class::sendControlChange(byte ControlNumber,
                                    byte ControlValue,
-                                   byte Channel)    {
+                                   byte Channel,
+                                   byte Priority)   {
 
-    send(ControlChange, ControlNumber, ControlValue, Channel);
+    send(ControlChange, ControlNumber, ControlValue, Channel, Priority);
 
 }
 
 /*! \brief Send a Program Change message 
  \param ProgramNumber	The Program to select (0 to 127).
  \param Channel			The channel on which the message will be sent (1 to 16).
+ \param Priority		MIDI_PRIORITY_HIGH (default) or MIDI_PRIORITY_NORMAL.
  */
-void MIDI_Class::sendProgramChange(byte ProgramNumber, byte Channel)    {
+void MIDI_Class::sendProgramChange(byte ProgramNumber, byte Channel, byte Priority)    {
 
-    send(ProgramChange,ProgramNumber,0,Channel);
+    send(ProgramChange,ProgramNumber,0,Channel,Priority);
 
 }
 
@@ -219,15 +261,24 @@ void MIDI_Class::sendSysEx(int length,
                            const byte *const array,
                            bool ArrayContainsBoundaries)    {
 
+#if USE_TX_BUFFER
+    //SysEx can't be interrupted once started, so waiting notes go first,
+    //Control Change keeps waiting since its value can still be updated
+    txSchedule(TX_BUFFER_SIZE, false);
+#endif
+
+    //SysEx cancels running status
+    mRunningStatus_TX = InvalidType;
+
     if (ArrayContainsBoundaries == false) {
 
-        USE_SERIAL_PORT.write(0xF0);
+        txWrite(0xF0);
 
-        for (int i=0; i<length; ++i)    USE_SERIAL_PORT.write(array[i]);
+        for (int i=0; i<length; ++i)    txWrite(array[i]);
 
-        USE_SERIAL_PORT.write(0xF7);
+        txWrite(0xF7);
 
-    }   else    for (int i=0;i<length;++i)  USE_SERIAL_PORT.write(array[i]);
+    }   else    for (int i=0;i<length;++i)  txWrite(array[i]);
 
 }
 
@@ -246,7 +297,10 @@ void MIDI_Class::sendRealTime(kMIDIType Type)   {
         case Start:
         case Stop:  
         case Continue:
-        USE_SERIAL_PORT.write((byte)Type);
+        txWrite((byte)Type);
+        //Real Time messages don't cancel running status, but some
+        //receivers don't handle that properly, so refresh it anyway
+        mRunningStatus_TX = InvalidType;
         break;
 
         default:
@@ -257,8 +311,334 @@ void MIDI_Class::sendRealTime(kMIDIType Type)   {
 
 }
 
+
+/*! \brief Send channel message with already generated status byte.
+ */
+void MIDI_Class::sendChannelMessage(byte statusbyte,
+                                    byte data1,
+                                    byte data2)    {
+
+    bool twoDataBytes = ((statusbyte & 0xF0) != ProgramChange && (statusbyte & 0xF0) != 0xD0);
+    bool sendStatus = true;
+
+    //With running status, status byte is skipped if it's same as previous one,
+    //but it's still repeated periodically for receivers connected later
+    if (mRunningStatusTXenabled && (statusbyte == mRunningStatus_TX) &&
+        ((millis() - mRunningStatusTXtime) < RUNNING_STATUS_REFRESH_TIME))
+            sendStatus = false;
+
+#if USE_TX_BUFFER
+    //Message is either queued completely or not at all
+    if (!txReserve((twoDataBytes ? 2 : 1) + sendStatus))   return;
+#endif
+
+    if (sendStatus) {
+
+        txWrite(statusbyte);
+
+        if (mRunningStatusTXenabled)    {
+
+            mRunningStatus_TX = statusbyte;
+            mRunningStatusTXtime = millis();
+
+        }
+
+    }
+
+    // Then send data
+    txWrite(data1);
+
+    if (twoDataBytes)
+        txWrite(data2);
+
+}
+
+
+/*! \brief Move waiting messages to TX buffer. Call this often, from loop().
+ */
+void MIDI_Class::update()   {
+
+#if USE_TX_BUFFER
+
+    txSchedule(TX_SCHEDULE_THRESHOLD, true);
+
+#endif
+
+}
+
+
+/*! \brief Enable or disable running status for outgoing channel messages.
+ */
+void MIDI_Class::setRunningStatusTX(bool enabled) {
+
+    mRunningStatusTXenabled = enabled;
+    mRunningStatus_TX = InvalidType;
+
+}
+
+
+/*! \brief Write one byte to serial port, either directly or through TX buffer.
+ With TX buffer, this only waits if the buffer is full.
+ */
+void MIDI_Class::txWrite(byte value)    {
+
+#if USE_TX_BUFFER
+
+    //buffer is full, wait until transmitter makes room
+    txWaitRoom(1);
+
+    byte nextHead = (mTxHead + 1) & (TX_BUFFER_SIZE - 1);
+
+    mTxBuffer[mTxHead] = value;
+
+    cli();
+
+    mTxHead = nextHead;
+
+    byte pending = (mTxHead - mTxTail) & (TX_BUFFER_SIZE - 1);
+    if (pending > mTxHighWater) mTxHighWater = pending;
+
+    //transmitter is idle, send first byte, interrupt takes care of the rest
+    if (!mTxActive) {
+
+        mTxActive = true;
+        UCSR0B |= (1 << TXCIE0);
+        txComplete();
+
+    }
+
+    sei();
+
+#else
+
+    USE_SERIAL_PORT.write(value);
+
+#endif
+
+}
+
+
+#if USE_TX_BUFFER
+
+/*! \brief Check if there is room for message of given size in TX buffer.
+ Depending on TX_BUFFER_FULL_POLICY, either waits for room or drops the message.
+ */
+bool MIDI_Class::txReserve(byte size)   {
+
+#if TX_BUFFER_FULL_POLICY == TX_BUFFER_FULL_DROP
+
+    if (((TX_BUFFER_SIZE - 1) - getTxPending()) < size)    {
+
+        if (mTxDropped < 0xFFFF)    mTxDropped++;
+        return false;
+
+    }
+
 #endif
 
+    //with TX_BUFFER_FULL_WAIT, txWrite waits for room byte by byte
+    return true;
+
+}
+
+/*! \brief Wait until there is room for message of given size in TX buffer.
+ */
+void MIDI_Class::txWaitRoom(byte size)  {
+
+    while (((TX_BUFFER_SIZE - 1) - getTxPending()) < size)    {
+
+        //transmit complete interrupt can't run while interrupts are disabled, serve it here
+        if (UCSR0A & (1 << TXC0))   {
+
+            UCSR0A |= (1 << TXC0);
+            txComplete();
+
+        }
+
+    }
+
+}
+
+/*! \brief Move next byte from TX buffer to UART.
+ Called from transmit complete interrupt once previous byte is out.
+ */
+void MIDI_Class::txComplete()   {
+
+    byte tail = mTxTail;
+
+    if (tail == mTxHead)    {
+
+        mTxActive = false;
+        return;
+
+    }
+
+    UDR0 = mTxBuffer[tail];
+    mTxTail = (tail + 1) & (TX_BUFFER_SIZE - 1);
+
+}
+
+byte MIDI_Class::getTxPending() const   {
+
+    return (mTxHead - mTxTail) & (TX_BUFFER_SIZE - 1);
+
+}
+
+byte MIDI_Class::getTxHighWater() const {
+
+    return mTxHighWater;
+
+}
+
+word MIDI_Class::getTxDropped() const   {
+
+    return mTxDropped;
+
+}
+
+/*! \brief Keep normal priority message until TX buffer is almost empty.
+ Returns false if there is no room for Control Change, message should be sent right away then.
+ Notes and program changes are always queued, so that they can't overtake waiting ones,
+ and they are never dropped: if TX buffer is full too, this waits until oldest one fits.
+ */
+bool MIDI_Class::txQueue(byte statusbyte, byte data1, byte data2)   {
+
+#if CC_COALESCING_SLOTS
+    if ((statusbyte & 0xF0) == ControlChange)
+        return coalesceControlChange(statusbyte, data1, data2);
+#endif
+
+    if (mTxQueued == TX_NORMAL_QUEUE_SIZE)  {
+
+        //make room by moving waiting messages to TX buffer in order
+        txSchedule(TX_BUFFER_SIZE, false);
+
+        //TX buffer is full too, wait for room so that oldest message isn't dropped
+        if (mTxQueued == TX_NORMAL_QUEUE_SIZE)  {
+
+            txWaitRoom(3);
+            txSendQueued();
+
+        }
+
+    }
+
+    mTxQueueStatus[mTxQueued] = statusbyte;
+    mTxQueueData1[mTxQueued] = data1;
+    mTxQueueData2[mTxQueued] = data2;
+    mTxQueued++;
+
+    //don't wait if TX buffer is already almost empty
+    update();
+
+    return true;
+
+}
+
+/*! \brief Move waiting normal priority messages to TX buffer
+ while fewer than threshold bytes are pending and message fits.
+ */
+void MIDI_Class::txSchedule(byte threshold, bool controlChange) {
+
+    while ((getTxPending() < threshold) && (((TX_BUFFER_SIZE - 1) - getTxPending()) >= 3))    {
+
+        //notes and program changes keep their order and go before Control Change
+        if (mTxQueued)  txSendQueued();
+
+#if CC_COALESCING_SLOTS
+        //oldest Control Change goes first
+        else if (controlChange && mCCwaiting)   {
+
+            sendChannelMessage(mCCstatus[0], mCCnumber[0], mCCvalue[0]);
+
+            mCCwaiting--;
+
+            for (int i=0; i<mCCwaiting; i++)    {
+
+                mCCstatus[i] = mCCstatus[i+1];
+                mCCnumber[i] = mCCnumber[i+1];
+                mCCvalue[i] = mCCvalue[i+1];
+
+            }
+
+        }
+#endif
+
+        else break;
+
+    }
+
+}
+
+/*! \brief Send oldest waiting normal priority message.
+ */
+void MIDI_Class::txSendQueued() {
+
+    sendChannelMessage(mTxQueueStatus[0], mTxQueueData1[0], mTxQueueData2[0]);
+
+    mTxQueued--;
+
+    for (int i=0; i<mTxQueued; i++)    {
+
+        mTxQueueStatus[i] = mTxQueueStatus[i+1];
+        mTxQueueData1[i] = mTxQueueData1[i+1];
+        mTxQueueData2[i] = mTxQueueData2[i+1];
+
+    }
+
+}
+
+ISR(USART_TX_vect)  {
+
+    MIDI.txComplete();
+
+}
+
+#if CC_COALESCING_SLOTS
+
+/*! \brief Store Control Change in its slot, replacing value which hasn't been sent yet.
+ Returns false if there is no free slot, message should be sent right away then.
+ */
+bool MIDI_Class::coalesceControlChange(byte statusbyte, byte number, byte value)    {
+
+    for (int i=0; i<mCCwaiting; i++)    {
+
+        if ((mCCstatus[i] == statusbyte) && (mCCnumber[i] == number))  {
+
+            mCCvalue[i] = value;
+            if (mCCcoalesced < 0xFFFF)  mCCcoalesced++;
+            return true;
+
+        }
+
+    }
+
+    if (mCCwaiting == CC_COALESCING_SLOTS)  return false;
+
+    mCCstatus[mCCwaiting] = statusbyte;
+    mCCnumber[mCCwaiting] = number;
+    mCCvalue[mCCwaiting] = value;
+    mCCwaiting++;
+
+    //don't wait if TX buffer is already almost empty
+    update();
+
+    return true;
+
+}
+
+word MIDI_Class::getCCcoalesced() const {
+
+    return mCCcoalesced;
+
+}
+
+#endif // CC_COALESCING_SLOTS
+
+#endif // USE_TX_BUFFER
+
+#endif // COMPILE_MIDI_OUT
+
 
 
 #if COMPILE_MIDI_IN
@@ -280,26 +660,56 @@ bool MIDI_Class::read() {
 }
 
 
-/*! \brief Reading/thru-ing method, the same as read() with a given input channel to read on. */
+/*! \brief Reading/thru-ing method, the same as read() with a given input channel to read on.
+
+ With callbacks enabled, all bytes available in serial buffer are parsed (up to PARSE_BYTE_BUDGET
+ bytes or PARSE_TIME_BUDGET microseconds) and every completed message is dispatched to its callback.
+ Without callbacks, parsing stops on first valid message so that it can be read using getters.
+ */
 bool MIDI_Class::read(const byte inChannel) {
 
     if (inChannel >= MIDI_CHANNEL_OFF) return false; //MIDI Input disabled.
 
-    if (parse(inChannel)) {
+    bool messageReceived = false;
 
-        if (input_filter(inChannel)) {
+    #if USE_1BYTE_PARSING && (PARSE_BYTE_BUDGET > 1)
+        uint8_t parsedBytes = 0;
+        #if PARSE_TIME_BUDGET
+            uint32_t parseStartTime = micros();
+        #endif
+    #endif
 
-            #if USE_CALLBACKS
-                launchCallback();
-            #endif
+    do {
 
-                return true;
+        if (parse(inChannel)) {
+
+            if (input_filter(inChannel)) {
+
+                messageReceived = true;
+
+                #if USE_CALLBACKS
+                    launchCallback();
+                #else
+                    //keep message in structure until it's read
+                    break;
+                #endif
+
+            }
 
         }
 
-    }
+        #if USE_1BYTE_PARSING && (PARSE_BYTE_BUDGET > 1)
+            if (++parsedBytes >= PARSE_BYTE_BUDGET) break;
+            #if PARSE_TIME_BUDGET
+                if ((micros() - parseStartTime) >= PARSE_TIME_BUDGET) break;
+            #endif
+        #else
+            break;
+        #endif
 
-    return false;
+    }   while (USE_SERIAL_PORT.available() > 0);
+
+    return messageReceived;
 
 }
 
@@ -63,13 +63,51 @@
 #define USE_CALLBACKS           1           // Set this to 1 if you want to use callback handlers (to bind your functions to the library).
                                             // To use the callbacks, you need to have COMPILE_MIDI_IN set to 1
 
-#define USE_1BYTE_PARSING       1           // Each call to MIDI.read will only parse one byte (might be faster).
+#define USE_1BYTE_PARSING       1           // Each call to MIDI.parse will only parse one byte (might be faster).
+
+#define PARSE_BYTE_BUDGET       64          // With 1-byte parsing, MIDI.read keeps parsing bytes and dispatching completed
+                                            // messages until serial buffer is empty or this many bytes are parsed.
+                                            // Set to 1 to parse only one byte per MIDI.read call.
+
+#define PARSE_TIME_BUDGET       500         // Maximum time in microseconds one MIDI.read call can spend parsing
+                                            // (0 means no time limit, only PARSE_BYTE_BUDGET applies).
+
+#define RUNNING_STATUS_REFRESH_TIME 1000    // With TX running status enabled, status byte is repeated at least this often
+                                            // (in milliseconds), even if it didn't change.
+
+#define USE_TX_BUFFER           1           // Set this to 1 to queue outgoing bytes in TX ring buffer drained by UART transmit
+                                            // complete interrupt, so send functions don't wait for serial port.
+                                            // Library drives UDR0 directly, USE_SERIAL_PORT.write must not be used then.
+
+#define TX_BUFFER_SIZE          128         // Size of TX ring buffer, must be power of two (one byte is always kept free).
+
+#define TX_BUFFER_FULL_POLICY   TX_BUFFER_FULL_DROP     // What send functions do with channel message when TX buffer is full:
+                                                        // TX_BUFFER_FULL_DROP drops whole message and counts it,
+                                                        // TX_BUFFER_FULL_WAIT waits until there is enough space.
+                                                        // SysEx is never dropped, it always waits for free space.
+
+#define TX_SCHEDULE_THRESHOLD   3           // With TX buffer, normal priority messages wait until fewer bytes than this are pending
+                                            // in TX buffer, so high priority messages only queue behind a few bytes.
+
+#define TX_NORMAL_QUEUE_SIZE    8           // Number of normal priority Note and Program Change messages which can wait,
+                                            // in order, for TX buffer. When it's full, oldest ones are moved to TX buffer first,
+                                            // waiting for room if needed, so queued messages are never dropped.
+
+#define CC_COALESCING_SLOTS     16          // Normal priority Control Change waits in one of these slots (one per channel and
+                                            // controller number). Newer value for the same controller replaces waiting one,
+                                            // so only latest value is sent. 0 disables this.
 
 
 // END OF CONFIGURATION AREA 
 // (do not modify anything under this line unless you know what you are doing)
 
 
+#define TX_BUFFER_FULL_DROP     0
+#define TX_BUFFER_FULL_WAIT     1
+
+#define MIDI_PRIORITY_HIGH      0           // Message goes to TX buffer right away
+#define MIDI_PRIORITY_NORMAL    1           // Message waits until TX buffer is almost empty
+
 #define MIDI_CHANNEL_OMNI       0
 #define MIDI_CHANNEL_OFF        17          // and over
 
@@ -131,26 +169,85 @@ public:
     //Constructor
     MIDI_Class();
 
-    void begin(uint8_t);
+    void begin(uint8_t inChannel, bool runningStatusTX = false);
 
 /* ####### OUTPUT COMPILATION BLOCK ####### */  
 #if COMPILE_MIDI_OUT
 
 public: 
 
-    void sendNoteOn(byte NoteNumber,byte Velocity,byte Channel);
-    void sendNoteOff(byte NoteNumber,byte Velocity,byte Channel);
-    void sendControlChange(byte ControlNumber, byte ControlValue,byte Channel);
-    void sendProgramChange(byte ProgramNumber,byte Channel);
+    void sendNoteOn(byte NoteNumber,byte Velocity,byte Channel,byte Priority = MIDI_PRIORITY_HIGH);
+    void sendNoteOff(byte NoteNumber,byte Velocity,byte Channel,byte Priority = MIDI_PRIORITY_HIGH);
+    void sendControlChange(byte ControlNumber, byte ControlValue,byte Channel,byte Priority = MIDI_PRIORITY_NORMAL);
+    void sendProgramChange(byte ProgramNumber,byte Channel,byte Priority = MIDI_PRIORITY_HIGH);
     void sendPitchBend(uint16_t PitchValue, byte Channel);
     void sendSysEx(int length, const byte *const array,bool ArrayContainsBoundaries = false);   
     void sendRealTime(kMIDIType Type);
 
-    void send(kMIDIType type, byte param1, byte param2, byte channel);
+    void send(kMIDIType type, byte param1, byte param2, byte channel, byte priority = MIDI_PRIORITY_HIGH);
+
+    void setRunningStatusTX(bool enabled);
+
+    void update();
+
+#if USE_TX_BUFFER
+
+    // TX buffer statistics
+    byte getTxPending() const;
+    byte getTxHighWater() const;
+    word getTxDropped() const;
+#if CC_COALESCING_SLOTS
+    word getCCcoalesced() const;
+#endif
+
+    // Called from UART transmit complete interrupt, don't call it from sketch.
+    void txComplete();
+
+#endif
 
 private:
 
     const byte  genstatus(const kMIDIType inType,const byte inChannel) const;
+    void sendChannelMessage(byte statusbyte, byte data1, byte data2);
+    void txWrite(byte value);
+
+    bool            mRunningStatusTXenabled;
+    byte            mRunningStatus_TX;
+    uint32_t        mRunningStatusTXtime;
+
+#if USE_TX_BUFFER
+
+    bool txReserve(byte size);
+    void txWaitRoom(byte size);
+    bool txQueue(byte statusbyte, byte data1, byte data2);
+    void txSchedule(byte threshold, bool controlChange);
+    void txSendQueued();
+
+    byte            mTxQueueStatus[TX_NORMAL_QUEUE_SIZE],
+                    mTxQueueData1[TX_NORMAL_QUEUE_SIZE],
+                    mTxQueueData2[TX_NORMAL_QUEUE_SIZE];
+    byte            mTxQueued;
+
+    byte            mTxBuffer[TX_BUFFER_SIZE];
+    volatile byte   mTxHead,
+                    mTxTail;
+    volatile bool   mTxActive;
+    byte            mTxHighWater;
+    word            mTxDropped;
+
+#if CC_COALESCING_SLOTS
+
+    bool coalesceControlChange(byte statusbyte, byte number, byte value);
+
+    byte            mCCstatus[CC_COALESCING_SLOTS],
+                    mCCnumber[CC_COALESCING_SLOTS],
+                    mCCvalue[CC_COALESCING_SLOTS];
+    byte            mCCwaiting;
+    word            mCCcoalesced;
+
+#endif
+
+#endif
 
 #endif  // COMPILE_MIDI_OUT
 
@@ -0,0 +1,158 @@
+/*
+
+OpenDECK library v1.3
+File: Boards.h
+Last revision date: 2014-12-25
+Author: Igor Petrovic
+
+*/
+
+
+#ifndef BOARDS_H_
+#define BOARDS_H_
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include "SysEx.h"
+
+//all I/O ports have the same type
+typedef __typeof__(PORTB) ioRegister;
+
+typedef struct {
+
+    //matrix and mux size, muxes have 8 or 16 inputs
+    uint8_t     numberOfColumns,
+                numberOfButtonRows,
+                numberOfLEDrows,
+                numberOfMux,
+                muxInputs,
+                muxPin[8];
+
+    //pin directions and pull-up resistors for ports B, C and D
+    uint8_t     ddr[3],
+                pullUp[3];
+
+    //column select, bits outside of keep mask are replaced with columnSelect value
+    ioRegister  *columnPort;
+    uint8_t     columnKeepMask,
+                columnSelect[8];
+
+    //button rows are read as (rowPin & rowMask) >> rowShift
+    ioRegister  *rowPin;
+    uint8_t     rowMask,
+                rowShift;
+
+    //LED rows
+    ioRegister  *ledRowPort;
+    uint8_t     ledRowsMask,
+                ledRow[8];
+
+    //mux select, mux input is written as muxInput << muxShift
+    ioRegister  *muxPort;
+    uint8_t     muxKeepMask,
+                muxShift;
+
+} boardDescriptor;
+
+//boards are numbered by SYS_EX_BOARD_TYPE value
+#define BOARD_PARAMETER(board, parameter)   BOARD_PARAMETER_(board, parameter)
+#define BOARD_PARAMETER_(board, parameter)  BOARD_##board##_##parameter
+
+//OpenDeck reference board
+#define BOARD_1_COLUMNS                     8
+#define BOARD_1_BUTTON_ROWS                 4
+#define BOARD_1_LED_ROWS                    4
+#define BOARD_1_MUX                         2
+#define BOARD_1_MUX_INPUTS                  8
+
+#define BOARD_1_DESCRIPTOR  {                                                   \
+                                                                                \
+    BOARD_1_COLUMNS, BOARD_1_BUTTON_ROWS, BOARD_1_LED_ROWS, BOARD_1_MUX,        \
+    BOARD_1_MUX_INPUTS, { 7, 6 },                                               \
+                                                                                \
+    { 0x0F, 0x3F, 0x02 },                                                       \
+    { 0x00, 0x00, 0xFC },                                                       \
+                                                                                \
+    /* column switching is controlled by 74HC238 decoder */                     \
+    &PORTC, 0xC7,                                                               \
+    { 0x00, 0x20, 0x10, 0x30, 0x08, 0x28, 0x18, 0x38 },                         \
+                                                                                \
+    &PIND, 0xF0, 4,                                                             \
+                                                                                \
+    &PORTB, 0x0F,                                                               \
+    { 0x01, 0x02, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 },                         \
+                                                                                \
+    &PORTC, 0xF8, 0                                                             \
+                                                                                \
+}
+
+//Tannin
+#define BOARD_2_COLUMNS                     5
+#define BOARD_2_BUTTON_ROWS                 4
+#define BOARD_2_LED_ROWS                    1
+#define BOARD_2_MUX                         2
+#define BOARD_2_MUX_INPUTS                  8
+
+#define BOARD_2_DESCRIPTOR  {                                                   \
+                                                                                \
+    BOARD_2_COLUMNS, BOARD_2_BUTTON_ROWS, BOARD_2_LED_ROWS, BOARD_2_MUX,        \
+    BOARD_2_MUX_INPUTS, { 0, 1 },                                               \
+                                                                                \
+    { 0x10, 0x1C, 0x7E },                                                       \
+    { 0x0F, 0x00, 0x7C },                                                       \
+                                                                                \
+    /* there can only be one column active at the time, the rest is HIGH */     \
+    &PORTD, 0x83,                                                               \
+    { 0x78, 0x74, 0x6C, 0x5C, 0x3C, 0x00, 0x00, 0x00 },                         \
+                                                                                \
+    &PINB, 0x0F, 0,                                                             \
+                                                                                \
+    &PORTB, 0x10,                                                               \
+    { 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },                         \
+                                                                                \
+    &PORTC, 0xE3, 2                                                             \
+                                                                                \
+}
+
+//Tannin with four 16-channel muxes (CD74HC4067) on A0, A1, A6 and A7,
+//fourth mux select line is on PC5, needs MAX_NUMBER_OF_POTS 64
+#define BOARD_3_COLUMNS                     5
+#define BOARD_3_BUTTON_ROWS                 4
+#define BOARD_3_LED_ROWS                    1
+#define BOARD_3_MUX                         4
+#define BOARD_3_MUX_INPUTS                  16
+
+#define BOARD_3_DESCRIPTOR  {                                                   \
+                                                                                \
+    BOARD_3_COLUMNS, BOARD_3_BUTTON_ROWS, BOARD_3_LED_ROWS, BOARD_3_MUX,        \
+    BOARD_3_MUX_INPUTS, { 0, 1, 6, 7 },                                         \
+                                                                                \
+    { 0x10, 0x3C, 0x7E },                                                       \
+    { 0x0F, 0x00, 0x7C },                                                       \
+                                                                                \
+    &PORTD, 0x83,                                                               \
+    { 0x78, 0x74, 0x6C, 0x5C, 0x3C, 0x00, 0x00, 0x00 },                         \
+                                                                                \
+    &PINB, 0x0F, 0,                                                             \
+                                                                                \
+    &PORTB, 0x10,                                                               \
+    { 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },                         \
+                                                                                \
+    &PORTC, 0xC3, 2                                                             \
+                                                                                \
+}
+
+#if !FIXED_BOARD
+
+//ordered by board type, starting with SYS_EX_BOARD_TYPE_OPEN_DECK_1
+const boardDescriptor boardDescriptors[SYS_EX_BOARD_TYPE_END-SYS_EX_BOARD_TYPE_OPEN_DECK_1] PROGMEM = {
+
+    BOARD_1_DESCRIPTOR,
+    BOARD_2_DESCRIPTOR,
+    BOARD_3_DESCRIPTOR
+
+};
+
+#endif
+
+#endif /* BOARDS_H_ */
@@ -23,8 +23,9 @@ void OpenDeck::setNumberOfColumnPasses() {
 
     /*
 
-        Algorithm calculates how many times does it need to read whole row
-        before it can declare button reading stable.
+        Algorithm calculates how many same readings of a button it needs
+        before it can declare button reading stable. First and last reading
+        are at least MIN_BUTTON_DEBOUNCE_TIME apart.
 
     */
 
@@ -33,15 +34,17 @@ void OpenDeck::setNumberOfColumnPasses() {
 
     if ((MIN_BUTTON_DEBOUNCE_TIME % rowPassTime) > 0)   mod = 1;
 
-    numberOfColumnPasses = ((MIN_BUTTON_DEBOUNCE_TIME / rowPassTime) + mod);
+    numberOfColumnPasses = ((MIN_BUTTON_DEBOUNCE_TIME / rowPassTime) + mod) + 1;
 
-    setNumberOfLongPressPasses();
+    //vertical counters can't count further
+    if (numberOfColumnPasses > ((1 << DEBOUNCE_COUNTER_BITS) - 1))
+        numberOfColumnPasses = (1 << DEBOUNCE_COUNTER_BITS) - 1;
 
 }
 
-void OpenDeck::setNumberOfLongPressPasses() {
+void OpenDeck::setLongPressTime() {
 
-    longPressColumnPass = sysExGetButtonHwParameter(SYS_EX_BUTTON_HW_P_LONG_PRESS_TIME)*100 / getRowPassTime();
+    longPressTime = sysExGetButtonHwParameter(SYS_EX_BUTTON_HW_P_LONG_PRESS_TIME)*100;
 
 }
 
@@ -181,7 +184,7 @@ void OpenDeck::processMomentaryButton(uint8_t buttonNumber, bool buttonState)
 
                 }
 
-        }   handleLongPress(buttonNumber, buttonState);
+        }
 
 }
 
@@ -226,7 +229,7 @@ void OpenDeck::processLatchingButton(uint8_t buttonNumber, bool buttonState)
 
                 }
 
-        }   handleLongPress(buttonNumber, buttonState);
+        }
 
 }
 
@@ -242,53 +245,48 @@ void OpenDeck::setHandleButtonPPSend(void (*fptr)(uint8_t channel, uint8_t progr
 
 }
 
-void OpenDeck::readButtons(uint8_t currentColumn)    {
+void OpenDeck::readButtons(uint8_t currentColumn, uint8_t columnState)    {
 
     if ((_board != 0) && (bitRead(hardwareEnabled, SYS_EX_HW_CONFIG_BUTTONS)))    {
 
-        uint8_t columnState = 0;
+        //invert column reading because of pull-up resistors
+        columnState = ~columnState & ((1 << _numberOfButtonRows) - 1);
 
-        readButtonColumn(columnState);
+        //encoders are decoded from raw readings, debouncing would swallow quadrature steps
+        columnState &= ~processEncoderPairs(currentColumn, columnState);
+        columnState = debounceColumn(columnState, currentColumn);
 
-        if (columnStable(columnState, currentColumn))    {
+        //only buttons which changed state are processed
+        uint8_t changedButtons = columnState ^ previousButtonState[currentColumn];
 
-            for (int i=0; i<(_numberOfButtonRows); i++)   {
+        for (int i=0; changedButtons; i++, changedButtons >>= 1)   {
 
-                //extract current bit from olumnState variable
-                //invert extracted bit because of pull-up resistors
-                uint8_t buttonState = !((columnState >> i) & 0x01);
-                //get current button number based on row and column
-                uint8_t buttonNumber = currentColumn+i*_numberOfColumns;
-                //get encoder pair number based on buttonNumber and current row
-                //uint8_t encoderPair = getEncoderPairNumber(i, buttonNumber);
+            if (!(changedButtons & 0x01))   continue;
 
-                //if (!encoderPairEnabled[encoderPair])
-                    procesButtonReading(buttonNumber, buttonState);
+            //extract current bit from olumnState variable
+            uint8_t buttonState = ((columnState >> i) & 0x01);
+            //get current button number based on row and column
+            uint8_t buttonNumber = currentColumn+i*_numberOfColumns;
 
-                //else {
-//
-                    //processEncoderPair(encoderPair, columnState, i);
-                    ////skip next row since it's also part of current encoder
-                    //i++;
-//
-                //}
+            procesButtonReading(buttonNumber, buttonState);
 
-                updateButtonState(buttonNumber, buttonState);
+            if (buttonState) startLongPress(buttonNumber);
 
-            }
+            updateButtonState(buttonNumber, buttonState);
 
         }
 
-         lastColumnState[currentColumn] = columnState;
-
     }
 
 }
 
 void OpenDeck::updateButtonState(uint8_t buttonNumber, uint8_t buttonState) {
 
-    uint8_t arrayIndex = buttonNumber/8;
-    uint8_t buttonIndex = buttonNumber - 8*arrayIndex;
+    if (!_numberOfColumns)  return;
+
+    //states are stored per column, one bit per row
+    uint8_t arrayIndex = buttonNumber % _numberOfColumns;
+    uint8_t buttonIndex = buttonNumber / _numberOfColumns;
 
     //update state if it's different than last one
     if (bitRead(previousButtonState[arrayIndex], buttonIndex) != buttonState)
@@ -298,8 +296,10 @@ void OpenDeck::updateButtonState(uint8_t buttonNumber, uint8_t buttonState) {
 
 bool OpenDeck::getPreviousButtonState(uint8_t buttonNumber) {
 
-    uint8_t arrayIndex = buttonNumber/8;
-    uint8_t buttonIndex = buttonNumber - 8*arrayIndex;
+    if (!_numberOfColumns)  return false;
+
+    uint8_t arrayIndex = buttonNumber % _numberOfColumns;
+    uint8_t buttonIndex = buttonNumber / _numberOfColumns;
 
     return bitRead(previousButtonState[arrayIndex], buttonIndex);
 
@@ -308,44 +308,119 @@ bool OpenDeck::getPreviousButtonState(uint8_t buttonNumber) {
 void OpenDeck::resetLongPress(uint8_t buttonNumber) {
 
     setButtonLongPressed(buttonNumber, false);
-    longPressCounter[buttonNumber] = 0;
+
+    //stop waiting for long-press
+    for (int i=0; i<longPressQueued; i++)   {
+
+        if (longPressButton[i] == buttonNumber) {
+
+            removeLongPress(i);
+            return;
+
+        }
+
+    }
 
 }
 
-void OpenDeck::handleLongPress(uint8_t buttonNumber, bool buttonState) {
+void OpenDeck::startLongPress(uint8_t buttonNumber) {
 
-    //update longPressCounter if:
+    //start waiting for long-press if:
     //a) long-press is enabled
     //b) button is pressed
     //c) long-press isn't already sent
 
     if (getButtonPPenabled(buttonNumber)) return; //disable long-press feature when button is configured to send PP
 
-    if (buttonState && bitRead(buttonFeatures, SYS_EX_FEATURES_BUTTONS_LONG_PRESS) && getButtonPressed(buttonNumber) && !getButtonLongPressed(buttonNumber)) {
+    if (bitRead(buttonFeatures, SYS_EX_FEATURES_BUTTONS_LONG_PRESS) && getButtonPressed(buttonNumber) && !getButtonLongPressed(buttonNumber)) {
 
-        longPressCounter[buttonNumber]++;
+        //button can wait only once
+        resetLongPress(buttonNumber);
 
-        if (longPressCounter[buttonNumber] == longPressColumnPass) {
+        //too many buttons are held, this one won't send long-press
+        if (longPressQueued == LONG_PRESS_QUEUE_SIZE)   return;
 
-            sendButtonNoteDataCallback(buttonNote[buttonNumber], true, _longPressButtonNoteChannel);
-            setButtonLongPressed(buttonNumber, true);
+        longPressButton[longPressQueued] = buttonNumber;
+        longPressStart[longPressQueued] = millis();
+        longPressQueued++;
 
-        }
+    }
+
+}
+
+void OpenDeck::removeLongPress(uint8_t index)   {
+
+    longPressQueued--;
+
+    for (int i=index; i<longPressQueued; i++)   {
+
+        longPressButton[i] = longPressButton[i+1];
+        longPressStart[i] = longPressStart[i+1];
+
+    }
+
+}
+
+void OpenDeck::checkLongPress() {
+
+    //all buttons wait for the same time, so queue is sorted by
+    //deadline and only the oldest button needs to be checked
+    while (longPressQueued && ((uint16_t)((uint16_t)millis() - longPressStart[0]) >= longPressTime))  {
+
+        uint8_t buttonNumber = longPressButton[0];
+
+        removeLongPress(0);
+
+        //long-press could have been disabled in the meantime
+        if (!bitRead(buttonFeatures, SYS_EX_FEATURES_BUTTONS_LONG_PRESS) || !getButtonPressed(buttonNumber))
+            continue;
+
+        sendButtonNoteDataCallback(buttonNote[buttonNumber], true, _longPressButtonNoteChannel);
+        setButtonLongPressed(buttonNumber, true);
 
     }
 
 }
 
-bool OpenDeck::columnStable(uint8_t columnState, uint8_t activeColumn)   {
+uint8_t OpenDeck::debounceColumn(uint8_t columnState, uint8_t activeColumn)   {
 
-    //column reading is declared stable if there are numberOfColumnPasses same readings
-    if (columnState == lastColumnState[activeColumn])   {
+    /*
+
+        Each button has its own counter of readings which differ from its
+        debounced state. Counters are bit-sliced: bit n of every button in
+        column is kept in debounceCounter[column][n], so all buttons in column
+        are counted at once. Counter is reset when reading equals debounced
+        state, and button state changes once there are numberOfColumnPasses
+        different readings in a row.
+
+    */
+
+    uint8_t changed = columnState ^ debouncedColumnState[activeColumn];
+    uint8_t carry = changed;
+    uint8_t stable = changed;
+
+    for (int i=0; i<DEBOUNCE_COUNTER_BITS; i++) {
+
+        uint8_t counterBit = debounceCounter[activeColumn][i];
+        uint8_t nextCarry = counterBit & carry;
+
+        //increment changed buttons, clear the rest
+        counterBit = (counterBit ^ carry) & changed;
+        debounceCounter[activeColumn][i] = counterBit;
+        carry = nextCarry;
+
+        //compare counters with numberOfColumnPasses
+        if (bitRead(numberOfColumnPasses, i))   stable &= counterBit;
+        else                                    stable &= ~counterBit;
+
+    }
 
-        if (columnPassCounter[activeColumn] < numberOfColumnPasses) columnPassCounter[activeColumn]++;
+    //toggle stable buttons and restart their counters
+    for (int i=0; i<DEBOUNCE_COUNTER_BITS; i++)
+        debounceCounter[activeColumn][i] &= ~stable;
 
-    }   else columnPassCounter[activeColumn] = 0;
+    debouncedColumnState[activeColumn] ^= stable;
 
-    //iterate over rows if column readings are stable
-    return (columnPassCounter[activeColumn] == numberOfColumnPasses);
+    return debouncedColumnState[activeColumn];
 
 }
\ No newline at end of file
@@ -28,6 +28,11 @@ void OpenDeck::getConfiguration()   {
     getCCPPnumbers();
     getCCPPlowerLimits();
     getCCPPupperLimits();
+    getPotHysteresisSettings();
+    getPotCurves();
+    getPotPPsettleTimes();
+    getPotNoteZones();
+    getEncoderPairs();
     getLEDnotes();
     getLEDHwParameters();
 
@@ -36,7 +41,9 @@ void OpenDeck::getConfiguration()   {
 //individual configuration getters
 void OpenDeck::getHardwareConfig()        {
 
+    #if !FIXED_BOARD
     _board                      = eeprom_read_byte((uint8_t*)EEPROM_BOARD_TYPE);
+    #endif
     hardwareEnabled             = eeprom_read_byte((uint8_t*)EEPROM_HARDWARE_ENABLED);
 
 }
@@ -109,6 +116,8 @@ void OpenDeck::getCCPPnumbers()           {
     for (int i=0; i<MAX_NUMBER_OF_POTS; i++)
         ccppNumber[i] = eeprom_read_byte((uint8_t*)EEPROM_POT_CC_PP_NUMBER_START+i);
 
+    buildCClookup();
+
 }
 
 void OpenDeck::getCCPPlowerLimits()   {
@@ -120,8 +129,80 @@ void OpenDeck::getCCPPlowerLimits()   {
 
 void OpenDeck::getCCPPupperLimits()   {
 
-    for (int i=0; i<MAX_NUMBER_OF_POTS; i++)
+    //lower limits are already read
+    for (int i=0; i<MAX_NUMBER_OF_POTS; i++)    {
+
         ccUpperLimit[i] = eeprom_read_byte((uint8_t*)EEPROM_POT_UPPER_LIMIT_START+i);
+        updateCCscale(i);
+
+    }
+
+}
+
+void OpenDeck::getPotHysteresisSettings()  {
+
+    for (int i=0; i<MAX_NUMBER_OF_POTS; i++)    {
+
+        potHysteresis[i] = eeprom_read_byte((uint8_t*)EEPROM_POT_HYSTERESIS_START+i);
+
+        //EEPROM written by older firmware is erased there
+        if (potHysteresis[i] > SYS_EX_POT_HYSTERESIS_MAX)   potHysteresis[i] = SYS_EX_POT_HYSTERESIS_AUTO;
+
+    }
+
+}
+
+void OpenDeck::getPotCurves()   {
+
+    for (int i=0; i<MAX_NUMBER_OF_POTS; i++)    {
+
+        potCurve[i] = eeprom_read_byte((uint8_t*)EEPROM_POT_CURVE_START+i);
+
+        //EEPROM written by older firmware is erased there
+        if (potCurve[i] >= SYS_EX_POT_CURVE_END)    potCurve[i] = SYS_EX_POT_CURVE_LINEAR;
+
+    }
+
+    //tables are only rewritten where they don't match points
+    for (int i=0; i<SYS_EX_POT_USER_CURVES; i++)
+        buildUserCurve(i);
+
+}
+
+void OpenDeck::getPotPPsettleTimes()    {
+
+    for (int i=0; i<MAX_NUMBER_OF_POTS; i++)    {
+
+        potPPsettleTime[i] = eeprom_read_byte((uint8_t*)EEPROM_POT_PP_SETTLE_TIME_START+i);
+
+        //EEPROM written by older firmware is erased there
+        if (potPPsettleTime[i] > SYS_EX_POT_PP_SETTLE_TIME_MAX) potPPsettleTime[i] = SYS_EX_POT_PP_SETTLE_TIME_MAX;
+
+    }
+
+}
+
+void OpenDeck::getPotNoteZones()    {
+
+    for (int i=0; i<MAX_NUMBER_OF_POTS; i++)    {
+
+        potNoteZoneLayout[i] = eeprom_read_byte((uint8_t*)EEPROM_POT_NOTE_ZONE_LAYOUT_START+i);
+
+        //EEPROM written by older firmware is erased there
+        if (potNoteZoneLayout[i] >= SYS_EX_POT_NOTE_ZONE_LAYOUTS)   potNoteZoneLayout[i] = 0;
+
+    }
+
+    for (int i=0; i<SYS_EX_POT_NOTE_ZONE_LAYOUTS; i++)
+        buildNoteZones(i);
+
+}
+
+void OpenDeck::getEncoderPairs()         {
+
+    //bits are stored inverted, EEPROM written by older firmware is erased there
+    for (int i=0; i<MAX_NUMBER_OF_ENCODERS/8; i++)
+        encoderPairEnabled[i] = ~eeprom_read_byte((uint8_t*)EEPROM_ENCODER_PAIR_ENABLED_START+i);
 
 }
 
@@ -130,6 +211,8 @@ void OpenDeck::getLEDnotes()            {
     for (int i=0; i<MAX_NUMBER_OF_LEDS; i++)
         ledActNote[i] = eeprom_read_byte((uint8_t*)EEPROM_LED_ACT_NOTE_START+i);
 
+    buildLEDnoteMap();
+
 }
 
 void OpenDeck::getLEDHwParameters() {
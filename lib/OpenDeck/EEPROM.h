@@ -58,6 +58,19 @@ Author: Igor Petrovic
 #define EEPROM_LED_HW_P_START_UP_SWITCH_TIME 443
 #define EEPROM_LED_HW_P_START_UP_ROUTINE     444
 
+//per-pot blocks have room for 64 pots regardless of MAX_NUMBER_OF_POTS
+#define EEPROM_POT_HYSTERESIS_START         445
+#define EEPROM_POT_CURVE_START              509
+#define EEPROM_POT_USER_CURVE_START         573
+#define EEPROM_POT_PP_SETTLE_TIME_START     605
+#define EEPROM_POT_NOTE_ZONE_LAYOUT_START   669
+#define EEPROM_POT_NOTE_ZONE_START          733
+
+#define EEPROM_ENCODER_PAIR_ENABLED_START   765
+
+//user curves expanded to 128 values, built from points, not part of default configuration
+#define EEPROM_POT_USER_CURVE_TABLE_START   767
+
 
 //default controller settings
 const uint8_t defConf[] PROGMEM = {
@@ -92,7 +105,7 @@ const uint8_t defConf[] PROGMEM = {
     //no function
     //no function
     //no function
-    //no function
+    //running status
     //standard note off
     0b00000000,                             //005
 
@@ -655,6 +668,371 @@ const uint8_t defConf[] PROGMEM = {
     0x05, //start up LED switch time (x10mS)//443
     0x00, //start-up routine pattern        //444
 
+    //pot hysteresis
+    //0 - learned from noise on start-up
+    //1-64 - reading has to move this many ADC steps (of 1024) before new value is sent
+
+    0x00,                                   //445
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+
+    //pot response curve
+    //0 - linear
+    //1 - logarithmic
+    //2 - exponential
+    //3 - S-curve
+    //4 - user curve 1
+    //5 - user curve 2
+
+    0x00,                                   //509
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+
+    //user curve points, CC value at 0, 8.5, 16.9 ... 127
+    //defaults are linear
+
+    //user curve 1
+    0x00,                                   //573
+    0x08,
+    0x11,
+    0x19,
+    0x22,
+    0x2A,
+    0x33,
+    0x3B,
+    0x44,
+    0x4C,
+    0x55,
+    0x5D,
+    0x66,
+    0x6E,
+    0x77,
+    0x7F,
+
+    //user curve 2
+    0x00,                                   //589
+    0x08,
+    0x11,
+    0x19,
+    0x22,
+    0x2A,
+    0x33,
+    0x3B,
+    0x44,
+    0x4C,
+    0x55,
+    0x5D,
+    0x66,
+    0x6E,
+    0x77,
+    0x7F,
+
+    //pot program change settle time (x10mS)
+    0x19,                                   //605
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+    0x19,
+
+    //pot note zone layout
+    0x00,                                   //669
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+
+    //note zone layouts, number of zones followed by
+    //CC value at which each next zone starts
+
+    //layout 0, zones 0, 1-31, 32-63, 64-95, 96-126, 127
+    0x06,                                   //733
+    0x01,
+    0x20,
+    0x40,
+    0x60,
+    0x7F,
+    0x00,
+    0x00,
+
+    //layout 1, zones 0-63, 64-127
+    0x02,                                   //741
+    0x40,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+
+    //layout 2, zones 0-42, 43-84, 85-127
+    0x03,                                   //749
+    0x2B,
+    0x55,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+
+    //layout 3, zones 0-31, 32-63, 64-95, 96-127
+    0x04,                                   //757
+    0x20,
+    0x40,
+    0x60,
+    0x00,
+    0x00,
+    0x00,
+    0x00,
+
+    //disable encoder pair (0 enabled, 1 disabled)
+    //stored inverted so that EEPROM erased by older firmware leaves pairs disabled
+    //pair n is on column n%columns, rows 2*(n/columns) and 2*(n/columns)+1
+
+    //7-0
+    0xFF,                                   //765
+    //15-8
+    0xFF,
+
 };
 
 #endif /* EEPROM_H_ */
\ No newline at end of file
@@ -1,7 +1,7 @@
 /*
 
 OpenDECK library v1.3
-File: Buttons.cpp
+File: Encoders.cpp
 Last revision date: 2014-12-25
 Author: Igor Petrovic
 
@@ -20,67 +20,82 @@ bool direction = true;
 
 #define ENC_STABLE_AFTER 2
 
-//void OpenDeck::processEncoderPair(uint8_t encoderPair, uint8_t columnState, uint8_t row)    {
-//
-    //uint8_t newValues = 0;
-//
-    //switch (row)    {
-//
-        //case 0:
-        //case 1:
-        //newValues = (columnState >> 0) & 0x03;
-        //break;
-//
-        //case 2:
-        //case 3:
-        //newValues = (columnState >> 2) & 0x03;
-        //break;
-//
-        //case 4:
-        //case 5:
-        //newValues = (columnState >> 4) & 0x03;
-        //break;
-//
-        //case 6:
-        //case 7:
-        //newValues = (columnState >> 6) & 0x03;
-        //break;
-//
-        //default:
-        //break;
-//
-    //}
-//
-    ////shift last state two bytes left to make room for new one
-    //encoderPairState[encoderPair] <<= 2;
-    ////insert new values
-    //encoderPairState[encoderPair] |= newValues;
-//
-    //int8_t direction = enc_states[encoderPairState[encoderPair] & 0x0f];
-//
-    //switch (direction)  {
-//
-        //case -1:
-        ////do something
-        //break;
-//
-        //case 1:
-        ////do something
-        //break;
-//
-        //default:
-        //break;
-//
-    //}
-//
-//}
-
-uint8_t OpenDeck::getEncoderPairNumber(uint8_t row, uint8_t buttonNumber)   {
-
-    //check for whether row is even or not to calculate encoder pair
-    uint8_t rowEven = (row % 2 == 0);
-    //get encoder pair number based on current row and buttonNumber
-    return (buttonNumber - _numberOfColumns*!rowEven) - (row-1*!rowEven)*_numberOfButtonRows;
+void OpenDeck::setHandleEncoder(void (*fptr)(uint8_t ccNumber, uint8_t ccValue, uint8_t channel))  {
+
+    sendEncoderDataCallback = fptr;
+
+}
+
+bool OpenDeck::getEncoderPairEnabled(uint8_t encoderPair)   {
+
+    //pairs which don't exist on current board are never enabled
+    if (encoderPair >= _numberOfColumns*(_numberOfButtonRows/2))  return false;
+
+    uint8_t arrayIndex = encoderPair/8;
+    uint8_t encoderIndex = encoderPair - 8*arrayIndex;
+
+    return bitRead(encoderPairEnabled[arrayIndex], encoderIndex);
+
+}
+
+uint8_t OpenDeck::getEncoderPairNumber(uint8_t row, uint8_t column)   {
+
+    //A is on even row, B on next one, pairs are numbered like buttons on even rows
+    return column + (row/2)*_numberOfColumns;
+
+}
+
+uint8_t OpenDeck::processEncoderPairs(uint8_t currentColumn, uint8_t columnState)  {
+
+    //rows used by enabled encoders, these aren't processed as buttons
+    uint8_t encoderRows = 0;
+
+    for (int i=0; i<(_numberOfButtonRows & 0xFE); i+=2)   {
+
+        uint8_t encoderPair = getEncoderPairNumber(i, currentColumn);
+        if (encoderPair >= MAX_NUMBER_OF_ENCODERS)  break;
+
+        processEncoderPair(encoderPair, columnState, i);
+
+        if (getEncoderPairEnabled(encoderPair))
+            encoderRows |= (0x03 << i);
+
+    }
+
+    return encoderRows;
+
+}
+
+void OpenDeck::processEncoderPair(uint8_t encoderPair, uint8_t columnState, uint8_t row)    {
+
+    //two bits per encoder, four encoders in each byte
+    uint8_t arrayIndex = encoderPair/4;
+    uint8_t stateShift = (encoderPair - 4*arrayIndex)*2;
+
+    uint8_t newState = (columnState >> row) & 0x03;
+    uint8_t lastState = (encoderPairState[arrayIndex] >> stateShift) & 0x03;
+
+    //state is tracked for disabled pairs too, so enabling pair doesn't produce a step
+    encoderPairState[arrayIndex] &= ~(0x03 << stateShift);
+    encoderPairState[arrayIndex] |= (newState << stateShift);
+
+    if (!getEncoderPairEnabled(encoderPair))    return;
+
+    //lookup gives 0 if both inputs changed between two readings, direction is unknown then
+    encoderSteps[encoderPair] += enc_states[(lastState << 2) | newState];
+
+    if ((encoderSteps[encoderPair] < ENCODER_STEPS_PER_DETENT) &&
+        (encoderSteps[encoderPair] > -ENCODER_STEPS_PER_DETENT))    return;
+
+    //relative CC, 65 for clockwise, 63 for counter-clockwise
+    uint8_t ccValue = (encoderSteps[encoderPair] > 0) ? 65 : 63;
+    encoderSteps[encoderPair] = 0;
+
+    //CC number is note of button on A input
+    uint8_t buttonNumber = encoderPair % _numberOfColumns + row*_numberOfColumns;
+
+    if (sendEncoderDataCallback != NULL)
+        sendEncoderDataCallback(buttonNote[buttonNumber], ccValue, _buttonNoteChannel);
 
 }
 
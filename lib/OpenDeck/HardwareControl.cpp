@@ -9,11 +9,39 @@ Author: Igor Petrovic
 
 #include "OpenDeck.h"
 #include "Ownduino.h"
+#include "Boards.h"
 #include <avr/interrupt.h>
 
 volatile int8_t column = 0;
-volatile int8_t activeMux = 0;
-volatile bool changeSwitch = true;
+
+//button rows are sampled in ISR into back buffer, main loop
+//takes complete frames of all columns from front buffer
+volatile uint8_t buttonFrame[2][8];
+volatile uint8_t frameBuffer = 0;
+volatile bool frameReady = false;
+volatile uint16_t frameCounter = 0;
+volatile uint16_t missedFrames = 0;
+
+//pots are sampled in ADC interrupt, main loop
+//only processes samples marked as ready
+volatile uint16_t potSample[MAX_NUMBER_OF_POTS];
+volatile uint16_t potSampleReady[MAX_NUMBER_OF_POTS/8];
+volatile uint8_t adcMuxNumber = 0;
+volatile uint8_t adcMuxInput = 0;
+volatile bool adcSettling = true;
+volatile uint8_t adcSampleCount = 0;
+volatile uint16_t adcSum = 0;
+//set by pot scheduler, sum of fewer conversions is shifted up to 12 bits
+volatile uint8_t adcSamplesPerPot = 1 << POT_OVERSAMPLING_SHIFT;
+volatile uint8_t adcSampleShift = 0;
+static bool adcSampling = false;
+
+//descriptor of selected board
+#if FIXED_BOARD
+static const boardDescriptor activeBoard = BOARD_PARAMETER(FIXED_BOARD, DESCRIPTOR);
+#else
+static boardDescriptor activeBoard;
+#endif
 
 void OpenDeck::enableAnalogueInput(uint8_t muxNumber, uint8_t adcChannel)  {
 
@@ -26,36 +54,55 @@ void OpenDeck::enableAnalogueInput(uint8_t muxNumber, uint8_t adcChannel)  {
 
 void OpenDeck::initBoard()  {
 
-    if (_board == 0)    return;
+    #if !FIXED_BOARD
+    if ((_board <= SYS_EX_BOARD_TYPE_START) || (_board >= SYS_EX_BOARD_TYPE_END))    return;
+
+    //ADC interrupt would keep mux position of old board
+    bool potSampling = potSamplingRunning();
+    if (potSampling)    stopPotSampling();
+
+    //ISR and hot paths use copy of board descriptor from RAM,
+    //don't let ISR see half of it if board is changed with SysEx
+    cli();
+    memcpy_P(&activeBoard, &boardDescriptors[_board-SYS_EX_BOARD_TYPE_OPEN_DECK_1], sizeof(boardDescriptor));
+
+    //muxes which don't fit into pot arrays are left unread, SysEx won't select
+    //such board, but its type could have been stored by firmware with more pots
+    if (activeBoard.numberOfMux*activeBoard.muxInputs > MAX_NUMBER_OF_POTS)
+        activeBoard.numberOfMux = MAX_NUMBER_OF_POTS/activeBoard.muxInputs;
+
+    //matrix scan starts over, frame of old board is dropped
+    column = 0;
+    frameBuffer = 0;
+    frameReady = false;
+
+    //pot sampling starts over from first input of first mux
+    adcMuxNumber = 0;
+    adcMuxInput = 0;
+    adcSettling = true;
+    adcSampleCount = 0;
+    adcSum = 0;
+    sei();
+    #endif
 
     initPins();
 
-    switch (_board) {
-
-        case SYS_EX_BOARD_TYPE_TANNIN:
-        _numberOfMux = 2;
-        _numberOfColumns = 5;
-        _numberOfButtonRows = 4;
-        _numberOfLEDrows = 1;
-        enableAnalogueInput(0, 0);
-        enableAnalogueInput(1, 1);
-        break;
-
-        case SYS_EX_BOARD_TYPE_OPEN_DECK_1:
-        _numberOfMux = 2;
-        _numberOfColumns = 8;
-        _numberOfButtonRows = 4;
-        _numberOfLEDrows = 4;
-        enableAnalogueInput(1, 6);
-        enableAnalogueInput(0, 7);
-        break;
-
-        default:
-        break;
+    #if !FIXED_BOARD
+    _numberOfMux = activeBoard.numberOfMux;
+    _numberOfMuxInputs = activeBoard.muxInputs;
+    _numberOfColumns = activeBoard.numberOfColumns;
+    _numberOfButtonRows = activeBoard.numberOfButtonRows;
+    _numberOfLEDrows = activeBoard.numberOfLEDrows;
 
-    }
+    if (potSampling)    startPotSampling();
+    #endif
+
+    for (int i=0; i<_numberOfMux; i++)
+        enableAnalogueInput(i, activeBoard.muxPin[i]);
 
     setNumberOfColumnPasses();
+    setLongPressTime();
+    setPotOversampling();
 
     //configure column and analog pin switch timer
     setUpSwitchTimer();
@@ -68,324 +115,306 @@ void OpenDeck::initBoard()  {
 
 }
 
-void OpenDeck::initPins() {
+#if !FIXED_BOARD
+bool OpenDeck::boardPotsFit(uint8_t board)  {
 
-    switch (_board) {
+    const boardDescriptor *descriptor = &boardDescriptors[board-SYS_EX_BOARD_TYPE_OPEN_DECK_1];
 
-        case SYS_EX_BOARD_TYPE_TANNIN:
-        DDRB |= 0x10;
-        DDRC = 0x1C;
-        DDRD = 0x7E;
+    return (pgm_read_byte(&descriptor->numberOfMux)*pgm_read_byte(&descriptor->muxInputs) <= MAX_NUMBER_OF_POTS);
 
-        //enable internal pull-up resistors for button rows
-        PORTB |= 0x0F;
+}
+#endif
 
-        //set all columns to HIGH
-        PORTD |= 0x7C;
-        break;
+void OpenDeck::initPins() {
+
+    DDRB = activeBoard.ddr[0];
+    DDRC = activeBoard.ddr[1];
+    DDRD = activeBoard.ddr[2];
 
-        case SYS_EX_BOARD_TYPE_OPEN_DECK_1:
-        DDRD = 0x02;
-        DDRB = 0x0F;
-        DDRC = 0x3F;
+    //enable internal pull-up resistors for button rows and set columns
+    PORTB |= activeBoard.pullUp[0];
+    PORTC |= activeBoard.pullUp[1];
+    PORTD |= activeBoard.pullUp[2];
 
-        //enable internal pull-up resistors for button rows
-        PORTD = 0xFC;
+}
 
-        //select first column
-        PORTC = 0x00;
-        break;
+inline void activateColumnInline(uint8_t column)  {
 
-        default:
-        break;
+    ioRegister &port = *activeBoard.columnPort;
 
-    }
+    port = (port & activeBoard.columnKeepMask) | activeBoard.columnSelect[column];
 
 }
 
-inline void activateColumnInline(uint8_t column, uint8_t board)  {
+void OpenDeck::activateColumn(int8_t column)   {
 
-    switch (board) {
+    activateColumnInline(column);
 
-        case SYS_EX_BOARD_TYPE_TANNIN:
-        //there can only be one column active at the time, the rest is set to HIGH
-        switch (column)  {
+}
 
-            case 0:
-            PORTD = 0x7A;
-            break;
+inline void ledRowOnInline(uint8_t rowNumber)  {
 
-            case 1:
-            PORTD = 0x76;
-            break;
+    *activeBoard.ledRowPort |= activeBoard.ledRow[rowNumber];
 
-            case 2:
-            PORTD = 0x6E;
-            break;
+}
 
-            case 3:
-            PORTD = 0x5E;
-            break;
+void OpenDeck::ledRowOn(uint8_t rowNumber)  {
 
-            case 4:
-            PORTD = 0x3E;
-            break;
+    ledRowOnInline(rowNumber);
 
-            default:
-            break;
+}
 
-        }
+inline void ledRowsOffInline()   {
 
-        break;
+    //turn all LED rows off
+    *activeBoard.ledRowPort &= ~activeBoard.ledRowsMask;
 
-        case SYS_EX_BOARD_TYPE_OPEN_DECK_1:
-        //column switching is controlled by 74HC238 decoder
-        PORTC &= 0xC7;
-        switch (column) {
+}
 
-            case 0:
-            PORTC &= 0xC7;
-            break;
+void OpenDeck::ledRowsOff()   {
 
-            case 1:
-            PORTC |= (0xC7 | 0x20);
-            break;
+    ledRowsOffInline();
 
-            case 2:
-            PORTC |= (0xC7 | 0x10);
-            break;
+}
 
-            case 3:
-            PORTC |= (0xC7 | 0x30);
-            break;
+inline void setMuxInputInline(uint8_t muxInput) {
 
-            case 4:
-            PORTC |= (0xC7 | 0x08);
-            break;
+    ioRegister &port = *activeBoard.muxPort;
 
-            case 5:
-            PORTC |= (0xC7 | 0x28);
-            break;
+    port = (port & activeBoard.muxKeepMask) | (muxInput << activeBoard.muxShift);
 
-            case 6:
-            PORTC |= (0xC7 | 0x18);
-            break;
+}
 
-            case 7:
-            PORTC |= (0xC7 | 0x38);
-            break;
+void OpenDeck::setMuxInput(uint8_t muxInput)    {
 
-            default:
-            break;
+    //mux select can share port with columns, don't let ISR
+    //switch column between reading and writing the port
+    cli();
+    setMuxInputInline(muxInput);
+    sei();
 
-        }
-        break;
+}
 
-        default:
-        break;
+inline void readButtonColumnInline(uint8_t &buttonColumnState)    {
 
-    }
+    buttonColumnState = (*activeBoard.rowPin & activeBoard.rowMask) >> activeBoard.rowShift;
 
 }
 
-void OpenDeck::activateColumn(int8_t column)   {
-
-    activateColumnInline(column, _board);
+ISR(TIMER2_COMPA_vect)  {
 
-}
+    int8_t _column = column;
 
-inline void ledRowOnInline(uint8_t rowNumber, uint8_t board)  {
+    //sample button rows while previous column is still active
+    if (_column)    {
 
-    switch (board) {
+        uint8_t _frameBuffer = frameBuffer;
+        uint8_t rows;
 
-        case SYS_EX_BOARD_TYPE_TANNIN:
-        switch (rowNumber)  {
+        readButtonColumnInline(rows);
+        buttonFrame[_frameBuffer][_column-1] = rows;
 
-            case 0:
-            PORTB |= 0x10;
-            break;
+        if (_column >= activeBoard.numberOfColumns) {
 
-            default:
-            break;
+            //frame is complete, previous one is lost if main loop hasn't taken it
+            if (frameReady) missedFrames++;
+            frameBuffer = _frameBuffer ^ 1;
+            frameReady = true;
+            frameCounter++;
 
         }
 
-        break;
+    }
+
+    //switch column
+    if (_column >= activeBoard.numberOfColumns) _column = 0;
+    //turn off all LED rows before switching to next column
+    ledRowsOffInline();
+    activateColumnInline(_column);
+    _column++;
+    column = _column;
+
+}
+
+int8_t OpenDeck::getActiveColumn() {
+
+    int8_t _column = column;
 
-        case SYS_EX_BOARD_TYPE_OPEN_DECK_1:
-        switch (rowNumber)  {
+    //return currently active column
+    return (_column - 1);
 
-            case 0:
-            //turn on first LED row
-            PORTB |= 0x01;
-            break;
+}
 
-            case 1:
-            //turn on second LED row
-            PORTB |= 0x02;
-            break;
+bool OpenDeck::getButtonFrame(uint8_t *frame)   {
 
-            case 2:
-            //turn on third LED row
-            PORTB |= 0x04;
-            break;
+    if (!frameReady)    return false;
 
-            case 3:
-            //turn on fourth LED row
-            PORTB |= 0x08;
-            break;
+    //copy front buffer before ISR swaps it again
+    cli();
 
-            default:
-            break;
+    uint8_t front = frameBuffer ^ 1;
 
-        }
+    for (int i=0; i<_numberOfColumns; i++)
+        frame[i] = buttonFrame[front][i];
 
-        break;
-        
-        default:
-        break;
+    frameReady = false;
 
-    }
+    sei();
+
+    return true;
 
 }
 
-void OpenDeck::ledRowOn(uint8_t rowNumber)  {
+uint16_t OpenDeck::getFrameCounter()    {
+
+    cli();
+    uint16_t _frameCounter = frameCounter;
+    sei();
 
-    ledRowOnInline(rowNumber, _board);
+    return _frameCounter;
 
 }
 
-inline void ledRowsOffInline(uint8_t board)   {
+uint16_t OpenDeck::getMissedFrames()    {
 
-    switch (board) {
+    cli();
+    uint16_t _missedFrames = missedFrames;
+    sei();
 
-        case SYS_EX_BOARD_TYPE_TANNIN:
-        //turn all LED rows off
-        PORTB &= 0xEF;
-        break;
+    return _missedFrames;
 
-        case SYS_EX_BOARD_TYPE_OPEN_DECK_1:
-        PORTB &= 0xF0;
+}
 
-        break;
+ISR(ADC_vect)   {
 
-        default:
-        break;
+    //ADCL has to be read first
+    uint8_t low = ADCL;
+    uint16_t value = (ADCH << 8) | low;
 
-    }
+    uint8_t _muxNumber = adcMuxNumber;
+    uint8_t _muxInput = adcMuxInput;
 
-}
+    if (adcSettling)    {
 
-void OpenDeck::ledRowsOff()   {
+        //first conversion after switching mux input is discarded
+        adcSettling = false;
 
-    ledRowsOffInline(_board);
+    }   else if (++adcSampleCount < adcSamplesPerPot)   {
 
-}
+        //pot is converted several times in a row
+        adcSum += value;
 
-inline void setMuxInputInline(uint8_t muxInput, uint8_t board) {
+    }   else    {
 
-    switch (board) {
+        //sum of oversampled conversions is stored as one sample
+        potSample[_muxNumber*activeBoard.muxInputs+_muxInput] = (adcSum + value) << adcSampleShift;
+        potSampleReady[_muxNumber] |= (1 << _muxInput);
+        adcSampleCount = 0;
+        adcSum = 0;
 
-        case SYS_EX_BOARD_TYPE_TANNIN:
-        PORTC = muxInput << 2;
-        break;
+        //same input is sampled on all muxes before select lines are switched
+        if (++_muxNumber >= activeBoard.numberOfMux)    {
 
-        case SYS_EX_BOARD_TYPE_OPEN_DECK_1:
-        PORTC &= 0xF8;
-        PORTC |= muxInput;
-        break;
+            _muxNumber = 0;
+            if (++_muxInput >= activeBoard.muxInputs)   _muxInput = 0;
+            setMuxInputInline(_muxInput);
+            adcSettling = true;
 
-        default:
-        break;
+        }
+
+        setADCchannel(activeBoard.muxPin[_muxNumber]);
+        adcMuxNumber = _muxNumber;
+        adcMuxInput = _muxInput;
 
     }
 
+    //each finished conversion starts next one
+    ADCSRA |= (1 << ADSC);
+
 }
 
-void OpenDeck::setMuxInput(uint8_t muxInput)    {
+void OpenDeck::setPotOversampling()    {
 
-    setMuxInputInline(muxInput, _board);
+    /*
 
-}
+        ADC interrupt reads pots one after another, so time in which
+        all pots are refreshed grows with number of pots. Oversampling
+        is reduced until whole pass fits into POT_REFRESH_RATE_MIN.
+        Each input switch costs one discarded conversion, each
+        conversion some time in interrupt on top of ADC clocks.
 
-inline void readButtonColumnInline(uint8_t &buttonColumnState, uint8_t board)    {
+    */
 
-    switch (board) {
+    const uint32_t conversionCycles = 13*ADC_PRESCALER + 64;
+    uint8_t shift = POT_OVERSAMPLING_SHIFT;
 
-        case SYS_EX_BOARD_TYPE_TANNIN:
-        buttonColumnState = (PINB & 0x0F);
-        break;
+    while (shift && ((uint32_t)activeBoard.muxInputs*(1 + (activeBoard.numberOfMux << shift))*conversionCycles > F_CPU/POT_REFRESH_RATE_MIN))
+        shift--;
 
-        case SYS_EX_BOARD_TYPE_OPEN_DECK_1:
-        buttonColumnState = ((PIND >> 4) & 0x0F);
+    cli();
+    adcSamplesPerPot = 1 << shift;
+    adcSampleShift = POT_OVERSAMPLING_SHIFT - shift;
+    sei();
 
-        break;
+}
 
-        default:
-        break;
+void OpenDeck::startPotSampling()   {
 
-    }
+    adcMuxNumber = 0;
+    adcMuxInput = 0;
+    adcSettling = true;
+    adcSampleCount = 0;
+    adcSum = 0;
 
-}
+    for (int i=0; i<MAX_NUMBER_OF_POTS/8; i++)
+        potSampleReady[i] = 0;
 
-void OpenDeck::readButtonColumn(uint8_t &buttonColumnState) {
+    setMuxInput(0);
+    setADCchannel(getMuxPin(0));
 
-    readButtonColumnInline(buttonColumnState, _board);
+    ADCSRA |= (1 << ADIE) | (1 << ADSC);
+    adcSampling = true;
 
 }
 
-ISR(TIMER2_COMPA_vect)  {
+void OpenDeck::stopPotSampling()    {
 
-    int8_t _column = column;
-    int8_t _activeMux = activeMux;
-    bool _changeSwitch = changeSwitch;
-    uint8_t board = openDeck.getBoard();
-
-    switch(_changeSwitch)    {
-
-        case true:
-        //switch column
-        if (_column == openDeck.getNumberOfColumns()) _column = 0;
-        //turn off all LED rows before switching to next column
-        ledRowsOffInline(board);
-        activateColumnInline(_column, board);
-        _column++;
-        column = _column;
-        break;
-
-        case false:
-        //switch analogue input
-        if (openDeck.sysExRunning()) break;
-        if (_activeMux == openDeck.getNumberOfMux())    _activeMux = 0;
-        setADCchannel(openDeck.getMuxPin(_activeMux));
-        _activeMux++;
-        activeMux = _activeMux;
-        break;
-
-        default:
-        break;
+    cli();
+    ADCSRA &= ~(1 << ADIE);
+    sei();
 
-    }
+    //wait for last conversion and clear its flag
+    while (ADCSRA & (1 << ADSC));
+    ADCSRA |= (1 << ADIF);
 
-    _changeSwitch = !_changeSwitch;
-    changeSwitch = _changeSwitch;
+    adcSampling = false;
 
 }
 
-int8_t OpenDeck::getActiveColumn() {
+bool OpenDeck::potSamplingRunning() {
 
-    int8_t _column = column;
+    return adcSampling;
 
-    //return currently active column
-    return (_column - 1);
+}
+
+uint16_t OpenDeck::getReadyPots(uint8_t muxNumber)   {
+
+    //one bit per mux input, cleared once taken
+    cli();
+    uint16_t readyPots = potSampleReady[muxNumber];
+    potSampleReady[muxNumber] = 0;
+    sei();
+
+    return readyPots;
 
 }
 
-int8_t OpenDeck::getActiveMux() {
+uint16_t OpenDeck::getPotSample(uint8_t potNumber)  {
 
-    int8_t _activeMux = activeMux;
+    cli();
+    uint16_t sample = potSample[potNumber];
+    sei();
 
-    //return currently active column
-    return (_activeMux - 1);
+    return sample;
 
-}
\ No newline at end of file
+}
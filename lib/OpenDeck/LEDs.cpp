@@ -250,17 +250,44 @@ void OpenDeck::turnOffLED(uint8_t ledNumber)    {
 
 void OpenDeck::storeReceivedNoteOn(uint8_t channel, uint8_t note, uint8_t velocity)  {
 
-    receivedChannel = channel;
-    receivedNote = note;
-    receivedVelocity = velocity;
+    //channel is already filtered by MIDI library
+    uint8_t head = receivedNoteHead;
 
-    receivedNoteOnProcessed = false;
+    //queue is full, drop the note and count it
+    if ((uint8_t)(head - receivedNoteTail) == RECEIVED_NOTE_QUEUE_SIZE)   {
+
+        if (receivedNoteOverflow < 0xFFFF)  receivedNoteOverflow++;
+        return;
+
+    }
+
+    receivedNote[head & (RECEIVED_NOTE_QUEUE_SIZE - 1)] = note;
+    receivedVelocity[head & (RECEIVED_NOTE_QUEUE_SIZE - 1)] = velocity;
+
+    //publish the note only after it's written
+    receivedNoteHead = head + 1;
 
 }
 
 void OpenDeck::checkReceivedNoteOn()  {
 
-    if (!receivedNoteOnProcessed) setLEDState();
+    uint8_t tail = receivedNoteTail;
+
+    //process all notes received since last call
+    while (tail != receivedNoteHead)    {
+
+        setLEDState(receivedNote[tail & (RECEIVED_NOTE_QUEUE_SIZE - 1)], receivedVelocity[tail & (RECEIVED_NOTE_QUEUE_SIZE - 1)]);
+        tail++;
+
+    }
+
+    receivedNoteTail = tail;
+
+}
+
+uint16_t OpenDeck::getReceivedNoteOverflow()    {
+
+    return receivedNoteOverflow;
 
 }
 
@@ -427,7 +454,7 @@ void OpenDeck::handleLED(bool currentLEDstate, bool blinkMode, uint8_t _ledNumbe
 
 }
 
-void OpenDeck::setLEDState()    {
+void OpenDeck::setLEDState(uint8_t receivedNote, uint8_t receivedVelocity)  {
 
     bool currentLEDstate;
 
@@ -473,9 +500,12 @@ void OpenDeck::setLEDState()    {
 
         }
 
-    handleLED(currentLEDstate, blinkMode, getLEDnumber());
-
-    receivedNoteOnProcessed = true;
+    #if LED_NOTE_FAN_OUT
+    for (uint8_t ledNumber=getLEDnumber(receivedNote); ledNumber<MAX_NUMBER_OF_LEDS; ledNumber=ledNoteNext[ledNumber])
+        handleLED(currentLEDstate, blinkMode, ledNumber);
+    #else
+    handleLED(currentLEDstate, blinkMode, getLEDnumber(receivedNote));
+    #endif
 
 }
 
@@ -519,15 +549,30 @@ void OpenDeck::switchBlinkState()   {
 
 }
 
-uint8_t OpenDeck::getLEDnumber()   {
+void OpenDeck::buildLEDnoteMap()    {
 
-    //match LED activation note with its index
-    for (int i=0; i<MAX_NUMBER_OF_LEDS; i++)
-        if (ledActNote[i] == receivedNote) return i;
+    //since 128 is impossible note, use it to mark
+    //notes which don't match any LED
+    for (int i=0; i<128; i++)   ledNoteIndex[i] = 128;
+
+    //go backwards so that first LED with matching note ends up in map
+    for (int i=MAX_NUMBER_OF_LEDS-1; i>=0; i--)   {
+
+        if (ledActNote[i] > 127)    continue;
+
+        #if LED_NOTE_FAN_OUT
+        ledNoteNext[i] = ledNoteIndex[ledActNote[i]];
+        #endif
+        ledNoteIndex[ledActNote[i]] = i;
 
-    //since 128 is impossible note, return it in case
-    //that received note doesn't match any LED
-    return 128;
+    }
+
+}
+
+uint8_t OpenDeck::getLEDnumber(uint8_t receivedNote)   {
+
+    //match LED activation note with its index
+    return ledNoteIndex[receivedNote & 0x7F];
 
 }
 
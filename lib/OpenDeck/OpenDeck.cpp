@@ -15,6 +15,15 @@ Author: Igor Petrovic
 #include <avr/eeprom.h>
 #include <avr/interrupt.h>
 
+#if FIXED_BOARD
+//board parameters are constants, but still need storage when bound to reference
+const uint8_t OpenDeck::_board;
+const uint8_t OpenDeck::_numberOfColumns;
+const uint8_t OpenDeck::_numberOfButtonRows;
+const uint8_t OpenDeck::_numberOfLEDrows;
+const uint8_t OpenDeck::_numberOfMux;
+const uint8_t OpenDeck::_numberOfMuxInputs;
+#endif
 
 OpenDeck::OpenDeck()    {
 
@@ -22,9 +31,10 @@ OpenDeck::OpenDeck()    {
     sendButtonNoteDataCallback  =   NULL;
     sendButtonPPDataCallback    =   NULL;
     sendPotCCDataCallback       =   NULL;
+    sendEncoderDataCallback     =   NULL;
     sendPitchBendDataCallback   =   NULL;
-    sendPotNoteOnDataCallback   =   NULL;
-    sendPotNoteOffDataCallback  =   NULL;
+    sendPotNoteDataCallback     =   NULL;
+    sendPotPPDataCallback       =   NULL;
     sendSysExDataCallback       =   NULL;
 
 }
@@ -34,8 +44,8 @@ void OpenDeck::init()   {
 
     initVariables();
 
-    setADCprescaler(32);
-    set8bitADC();
+    setADCprescaler(ADC_PRESCALER);
+    set10bitADC();
 
     if (initialEEPROMwrite())   sysExSetDefaultConf();
     else getConfiguration(); //get all values from EEPROM
@@ -83,22 +93,43 @@ void OpenDeck::initVariables()  {
         buttonType[i]               = 0;
         buttonPressed[i]            = 0;
         longPressSent[i]            = 0;
-        longPressCounter[i]         = 0;
         buttonPPenabled[i]          = 0;
 
     }
 
     numberOfColumnPasses            = 0;
-    longPressColumnPass             = 0;
+    longPressQueued                 = 0;
+    longPressTime                   = 0;
+
+    //encoders
+    for (i=0; i<MAX_NUMBER_OF_ENCODERS; i++)
+        encoderSteps[i]             = 0;
+
+    for (i=0; i<MAX_NUMBER_OF_ENCODERS/8; i++)
+        encoderPairEnabled[i]       = 0;
+
+    for (i=0; i<MAX_NUMBER_OF_ENCODERS/4; i++)
+        encoderPairState[i]         = 0;
 
     //pots
     for (i=0; i<MAX_NUMBER_OF_POTS; i++)        {
 
         ccppNumber[i]               = 0;
-        lastPotNoteValue[i]         = 128;
+        lastPotNoteZone[i]          = POT_NOTE_ZONE_NONE;
+        potNoteZoneLayout[i]        = 0;
+        potPickupTarget[i]          = POT_PICKUP_NONE;
         lastAnalogueValue[i]        = 0;
+        potFilter[i]                = 0;
         ccLowerLimit[i]             = 0;
         ccUpperLimit[i]             = 0;
+        ccScale[i]                  = 0;
+        potHysteresis[i]            = 0;
+        learnedPotHysteresis[i]     = 0;
+        potCurve[i]                 = 0;
+        potPPsettleTime[i]          = 0;
+        potPPprogram[i]             = 0;
+        lastPotPP[i]                = 128;
+        potPPchangeTime[i]          = 0;
 
     }
 
@@ -107,15 +138,33 @@ void OpenDeck::initVariables()  {
         potInverted[i]              = 0;
         potEnabled[i]               = 0;
         potPPenabled[i]             = 0;
+        potPPpending[i]             = 0;
+        potPickupAbove[i]           = 0;
+
+    }
+
+    userCurveChanged                = 0;
+
+    for (i=0; i<POT_CC_LOOKUP_SIZE; i++)
+        potCClookup[i]              = 0xFF;
+
+    for (i=0; i<SYS_EX_POT_NOTE_ZONE_LAYOUTS; i++)  {
+
+        noteZoneCount[i]            = 1;
+
+        for (int j=0; j<SYS_EX_POT_NOTE_ZONES_MAX; j++)
+            noteZoneStart[i][j]     = 128;
 
     }
 
     for (i=0; i<8; i++)                         {
 
-        lastColumnState[i] = 0;
-        columnPassCounter[i] = 0;
+        debouncedColumnState[i] = 0;
         analogueEnabledArray[i] = 0;
 
+        for (int j=0; j<DEBOUNCE_COUNTER_BITS; j++)
+            debounceCounter[i][j] = 0;
+
     }
 
     //LEDs
@@ -126,6 +175,8 @@ void OpenDeck::initVariables()  {
 
     }
 
+    buildLEDnoteMap();
+
     totalNumberOfLEDs               = 0;
 
     blinkState                      = true;
@@ -133,17 +184,25 @@ void OpenDeck::initVariables()  {
     blinkTimerCounter               = 0;
 
     //input
-    receivedNoteOnProcessed         = true;
-    receivedChannel                 = 0;
-    receivedNote                    = 0;
-    receivedVelocity                = 0;
+    for (i=0; i<RECEIVED_NOTE_QUEUE_SIZE; i++)  {
+
+        receivedNote[i]             = 0;
+        receivedVelocity[i]         = 0;
+
+    }
+
+    receivedNoteHead                = 0;
+    receivedNoteTail                = 0;
+    receivedNoteOverflow            = 0;
 
     //sysex
     sysExEnabled                    = false;
     _sysExRunning                   = false;
 
     //board type
+    #if !FIXED_BOARD
     _board                          = 0;
+    #endif
 
 }
 
@@ -151,11 +210,10 @@ void OpenDeck::setUpSwitchTimer()   {
 
     /*
 
-        This timer is used to switch columns in matrix, and also
-        to switch analogue input pin on ATmega328p. It's configured
-        to run every 500 microseconds. Interrupt routine either switches
-        matrix column, or analogue pin, which results in column/analog pin
-        switching every 1ms.
+        This timer is used to switch columns in matrix. It's configured
+        to run every millisecond. Button rows are sampled right before
+        column is switched, so they've had whole 1ms to settle. Pots
+        don't depend on it, ADC interrupt schedules its own conversions.
 
     */
 
@@ -170,7 +228,7 @@ void OpenDeck::setUpSwitchTimer()   {
     TCCR2B |= (1 << CS22);
 
     //set compare match register to desired timer count
-    OCR2A = 124;
+    OCR2A = 249;
 
     //enable CTC interrupt
     TIMSK2 |= (1 << OCIE2A);
@@ -188,13 +246,20 @@ void OpenDeck::processMatrix()  {
         //column are active, turn them on
         checkLEDs(currentColumn);
 
-        //check buttons on current column
-        readButtons(currentColumn);
-
         previousColumn = currentColumn;
 
     }
 
+    //buttons are sampled in ISR, so no column is skipped
+    //even if loop takes longer than column switch time
+    uint8_t frame[8];
+
+    if (getButtonFrame(frame))
+        for (int i=0; i<_numberOfColumns; i++)  readButtons(i, frame[i]);
+
+    //send long-press notes once their time is up
+    checkLongPress();
+
 }
 
 uint8_t OpenDeck::getNumberOfColumns()  {
@@ -209,6 +274,12 @@ uint8_t OpenDeck::getNumberOfMux()    {
 
 }
 
+uint8_t OpenDeck::getNumberOfMuxInputs()  {
+
+    return _numberOfMuxInputs;
+
+}
+
 uint8_t OpenDeck::getBoard()    {
 
     return _board;
@@ -227,6 +298,12 @@ bool OpenDeck::standardNoteOffEnabled() {
 
 }
 
+bool OpenDeck::runningStatusEnabled()   {
+
+    return bitRead(midiFeatures, SYS_EX_FEATURES_MIDI_RUNNING_STATUS);
+
+}
+
 void OpenDeck::stopSwitchTimer()    {
 
     TIMSK2 &= (0 << OCIE2A);
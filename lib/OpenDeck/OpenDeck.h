@@ -16,7 +16,31 @@ Author: Igor Petrovic
 #include "EEPROM.h"
 #include "SysEx.h"
 
+//set to board type (1 OpenDeck, 2 Tannin, 3 Tannin with 16-channel muxes) to build firmware for that board only,
+//board parameters then become constants and code for other boards is left out
+//0 selects board from EEPROM at runtime
+#ifndef FIXED_BOARD
+#define FIXED_BOARD                 0
+#endif
+
+#include "Boards.h"
+
+//each pot takes about 24 bytes of RAM, EEPROM has room for configuration of 64 pots
+//static data with 16 pots is about 1.8 kB in host build (not measured with avr-size),
+//so ATmega328p is left with little more than 200 bytes of stack, boards with more
+//pots than this can't be selected with SysEx
+#ifndef MAX_NUMBER_OF_POTS
 #define MAX_NUMBER_OF_POTS          16
+#endif
+
+#if (MAX_NUMBER_OF_POTS > 64) || (MAX_NUMBER_OF_POTS % 8)
+#error "MAX_NUMBER_OF_POTS must be multiple of 8, up to 64"
+#endif
+
+#if FIXED_BOARD && ((BOARD_PARAMETER(FIXED_BOARD, MUX)*BOARD_PARAMETER(FIXED_BOARD, MUX_INPUTS)) > MAX_NUMBER_OF_POTS)
+#error "MAX_NUMBER_OF_POTS is too small for all pots on fixed board"
+#endif
+
 #define MAX_NUMBER_OF_BUTTONS       64
 #define MAX_NUMBER_OF_LEDS          64
 #define MAX_NUMBER_OF_ENCODERS      16
@@ -30,6 +54,54 @@ Author: Igor Petrovic
 
 #define COLUMN_SCAN_TIME 1
 
+//buttons are debounced with vertical counters which count up to 2^bits-1
+//column passes, enough for MIN_BUTTON_DEBOUNCE_TIME with 2 or more columns
+#define DEBOUNCE_COUNTER_BITS       4
+
+//encoders wired into two adjacent button rows go through this many
+//quadrature steps per detent, each detent sends one relative CC
+#define ENCODER_STEPS_PER_DETENT    4
+
+//number of buttons which can wait for long-press at the same time
+#define LONG_PRESS_QUEUE_SIZE       8
+
+//pots are read with 10-bit ADC and oversampled in ADC interrupt,
+//2^shift conversions are summed into one 12-bit sample
+#define POT_OVERSAMPLING_SHIFT      2
+
+//ADC clock is F_CPU/prescaler, conversion takes 13 ADC clocks
+#define ADC_PRESCALER               32
+
+//pots are oversampled less on boards with many pots so that
+//each pot is still sampled at least this many times per second
+#define POT_REFRESH_RATE_MIN        200
+
+//pot hasn't sent any note yet
+#define POT_NOTE_ZONE_NONE          0xFF
+
+//pot isn't waiting to pick up value received from host
+#define POT_PICKUP_NONE             0xFF
+
+//pots are found by CC number in open addressing table, slots are
+//masked with size-1, so it's power of two at least 2*MAX_NUMBER_OF_POTS
+#if MAX_NUMBER_OF_POTS <= 8
+#define POT_CC_LOOKUP_SIZE          16
+#elif MAX_NUMBER_OF_POTS <= 16
+#define POT_CC_LOOKUP_SIZE          32
+#elif MAX_NUMBER_OF_POTS <= 32
+#define POT_CC_LOOKUP_SIZE          64
+#else
+#define POT_CC_LOOKUP_SIZE          128
+#endif
+
+//must be power of two, up to 128
+//MIDI.read can parse up to 64 bytes per call, which is at most 32 notes with running status
+#define RECEIVED_NOTE_QUEUE_SIZE    32
+
+//set to 1 to control all LEDs sharing same activation note with one note,
+//otherwise only first LED with matching note is used
+#define LED_NOTE_FAN_OUT            0
+
 class OpenDeck  {
 
     public:
@@ -43,17 +115,19 @@ class OpenDeck  {
     //buttons
     void setHandleButtonNoteSend(void (*fptr)(uint8_t, bool, uint8_t));
     void setHandleButtonPPSend(void (*fptr)(uint8_t, uint8_t));
-    void readButtons(uint8_t);
+    void readButtons(uint8_t, uint8_t);
 
     //pots
     void setHandlePotCC(void (*fptr)(uint8_t, uint8_t, uint8_t));
-    void setHandlePotNoteOn(void (*fptr)(uint8_t, uint8_t));
-    void setHandlePotNoteOff(void (*fptr)(uint8_t, uint8_t));
+    void setHandlePotNote(void (*fptr)(uint8_t, uint8_t, uint8_t, uint8_t));
+    void setHandlePotPP(void (*fptr)(uint8_t, uint8_t));
     uint8_t getMuxPin(uint8_t);
+    void storeReceivedControlChange(uint8_t, uint8_t, uint8_t);
     void readPots();
 
     //encoders
     void readEncoders(int32_t);
+    void setHandleEncoder(void (*fptr)(uint8_t, uint8_t, uint8_t));
     void setHandlePitchBend(void (*fptr)(uint16_t, uint8_t));
 
     //LEDs
@@ -64,17 +138,22 @@ class OpenDeck  {
     void turnOffLED(uint8_t);
     void storeReceivedNoteOn(uint8_t, uint8_t, uint8_t);
     void checkReceivedNoteOn();
+    uint16_t getReceivedNoteOverflow();
     void checkLEDs(uint8_t);
 
     //matrix
     void activateColumn(int8_t);
     void processMatrix();
+    uint16_t getFrameCounter();
+    uint16_t getMissedFrames();
 
     //getters
     uint8_t getInputMIDIchannel();
     bool standardNoteOffEnabled();
+    bool runningStatusEnabled();
     uint8_t getNumberOfColumns();
     uint8_t getNumberOfMux();
+    uint8_t getNumberOfMuxInputs();
     uint8_t getBoard();
     bool sysExRunning();
 
@@ -90,6 +169,9 @@ class OpenDeck  {
     void processSysEx(uint8_t sysExArray[], uint8_t);
     bool sysExSetDefaultConf();
 
+    //host simulator pushes pot readings through readPotsMux directly
+    friend void benchmarkPotReadings();
+
     private:
 
     //variables
@@ -120,12 +202,22 @@ class OpenDeck  {
                     previousButtonState[MAX_NUMBER_OF_BUTTONS/8],
                     buttonPressed[MAX_NUMBER_OF_BUTTONS/8],
                     longPressSent[MAX_NUMBER_OF_BUTTONS/8],
-                    longPressCounter[MAX_NUMBER_OF_BUTTONS],
-                    longPressColumnPass,
-                    lastColumnState[8],
-                    columnPassCounter[8],
+                    longPressButton[LONG_PRESS_QUEUE_SIZE],
+                    longPressQueued,
+                    debouncedColumnState[8],
+                    debounceCounter[8][DEBOUNCE_COUNTER_BITS],
                     numberOfColumnPasses;
 
+    uint16_t        longPressStart[LONG_PRESS_QUEUE_SIZE],
+                    longPressTime;
+
+    //encoders, last state of A and B inputs is packed in two bits per encoder
+    uint8_t         encoderPairEnabled[MAX_NUMBER_OF_ENCODERS/8],
+                    encoderPairState[MAX_NUMBER_OF_ENCODERS/4];
+
+    //quadrature steps since last detent
+    int8_t          encoderSteps[MAX_NUMBER_OF_ENCODERS];
+
     //pots
     uint8_t         potEnabled[MAX_NUMBER_OF_POTS/8],
                     potPPenabled[MAX_NUMBER_OF_POTS/8],
@@ -133,12 +225,43 @@ class OpenDeck  {
                     ccppNumber[MAX_NUMBER_OF_POTS],
                     ccLowerLimit[MAX_NUMBER_OF_POTS],
                     ccUpperLimit[MAX_NUMBER_OF_POTS],
-                    lastPotNoteValue[MAX_NUMBER_OF_POTS];
+                    lastPotNoteZone[MAX_NUMBER_OF_POTS],
+                    potNoteZoneLayout[MAX_NUMBER_OF_POTS],
+                    potHysteresis[MAX_NUMBER_OF_POTS],
+                    learnedPotHysteresis[MAX_NUMBER_OF_POTS],
+                    potCurve[MAX_NUMBER_OF_POTS],
+                    userCurveChanged,
+                    potPPsettleTime[MAX_NUMBER_OF_POTS],
+                    potPPprogram[MAX_NUMBER_OF_POTS],
+                    lastPotPP[MAX_NUMBER_OF_POTS],
+                    potPPpending[MAX_NUMBER_OF_POTS/8],
+                    noteZoneCount[SYS_EX_POT_NOTE_ZONE_LAYOUTS],
+                    potPickupTarget[MAX_NUMBER_OF_POTS],
+                    potPickupAbove[MAX_NUMBER_OF_POTS/8],
+                    potCClookup[POT_CC_LOOKUP_SIZE];
+
+    //CC value at which zones 1 and up start, 128 past last zone
+    uint8_t         noteZoneStart[SYS_EX_POT_NOTE_ZONE_LAYOUTS][SYS_EX_POT_NOTE_ZONES_MAX];
 
     uint16_t        lastAnalogueValue[MAX_NUMBER_OF_POTS];
 
+    //filtered pot readings, 12.4 fixed point
+    uint16_t        potFilter[MAX_NUMBER_OF_POTS];
+
+    //distance between CC limits divided by 127, 1.15 fixed point
+    uint16_t        ccScale[MAX_NUMBER_OF_POTS];
+
+    //time when pot moved to pending program, lower bits of millis()
+    uint16_t        potPPchangeTime[MAX_NUMBER_OF_POTS];
+
     //LEDs
     uint8_t         ledActNote[MAX_NUMBER_OF_LEDS];
+    //note to LED index, 128 if no LED uses the note
+    uint8_t         ledNoteIndex[128];
+    #if LED_NOTE_FAN_OUT
+    //next LED with same activation note, 128 at the end of chain
+    uint8_t         ledNoteNext[MAX_NUMBER_OF_LEDS];
+    #endif
     uint16_t        _blinkTime;
     uint8_t         totalNumberOfLEDs;
     uint8_t         ledState[MAX_NUMBER_OF_LEDS];
@@ -149,18 +272,33 @@ class OpenDeck  {
     uint32_t        blinkTimerCounter;
 
     //input
-    bool            receivedNoteOnProcessed;
+    //single-producer/single-consumer queue, MIDI callback writes, checkReceivedNoteOn reads
+    uint8_t         receivedNote[RECEIVED_NOTE_QUEUE_SIZE],
+                    receivedVelocity[RECEIVED_NOTE_QUEUE_SIZE];
+
+    //indexes run freely and are masked on access, head-tail is number of
+    //queued notes, so all slots can be used without separate count
+    volatile uint8_t    receivedNoteHead,
+                        receivedNoteTail;
 
-    uint8_t         receivedChannel,
-                    receivedNote,
-                    receivedVelocity;
+    uint16_t        receivedNoteOverflow;
 
     //hardware
+    #if FIXED_BOARD
+    static const uint8_t    _board              = FIXED_BOARD,
+                            _numberOfColumns    = BOARD_PARAMETER(FIXED_BOARD, COLUMNS),
+                            _numberOfButtonRows = BOARD_PARAMETER(FIXED_BOARD, BUTTON_ROWS),
+                            _numberOfLEDrows    = BOARD_PARAMETER(FIXED_BOARD, LED_ROWS),
+                            _numberOfMux        = BOARD_PARAMETER(FIXED_BOARD, MUX),
+                            _numberOfMuxInputs  = BOARD_PARAMETER(FIXED_BOARD, MUX_INPUTS);
+    #else
     uint8_t         _board,
                     _numberOfColumns,
                     _numberOfButtonRows,
                     _numberOfLEDrows,
-                    _numberOfMux;
+                    _numberOfMux,
+                    _numberOfMuxInputs;
+    #endif
 
     uint8_t         analogueEnabledArray[8];
 
@@ -191,6 +329,11 @@ class OpenDeck  {
     void getCCPPnumbers();
     void getCCPPlowerLimits();
     void getCCPPupperLimits();
+    void getPotHysteresisSettings();
+    void getPotCurves();
+    void getPotPPsettleTimes();
+    void getPotNoteZones();
+    void getEncoderPairs();
     void getLEDnotes();
     void getLEDHwParameters();
 
@@ -211,32 +354,53 @@ class OpenDeck  {
     void processLatchingButton(uint8_t, bool);
     void updateButtonState(uint8_t, uint8_t);
     bool getPreviousButtonState(uint8_t);
-    void setNumberOfLongPressPasses();
+    void setLongPressTime();
     void resetLongPress(uint8_t);
-    void handleLongPress(uint8_t, bool);
+    void startLongPress(uint8_t);
+    void removeLongPress(uint8_t);
+    void checkLongPress();
 
     //pots
     void (*sendPotCCDataCallback)(uint8_t, uint8_t, uint8_t);
-    void (*sendPotNoteOnDataCallback)(uint8_t, uint8_t);
-    void (*sendPotNoteOffDataCallback)(uint8_t, uint8_t);
+    void (*sendPotNoteDataCallback)(uint8_t, uint8_t, uint8_t, uint8_t);
+    void (*sendPotPPDataCallback)(uint8_t, uint8_t);
     uint8_t getPotNumber(uint8_t, uint8_t);
-    void readPotsMux(uint8_t, uint8_t);
+    void readPotsMux(uint8_t, uint8_t, int16_t);
     bool checkPotReading(int16_t, uint8_t);
     void processPotReading(int16_t, uint8_t);
     bool getPotEnabled(uint8_t);
     bool getPotPPenabled(uint8_t);
     bool getPotInvertState(uint8_t);
     uint8_t getCCnumber(uint8_t);
-    uint8_t getPotNoteValue(uint8_t, uint8_t);
-    bool checkPotNoteValue(uint8_t, uint8_t);
-    int8_t getActiveMux();
+    uint8_t getPotNoteZone(uint8_t, uint8_t);
+    uint8_t getPotNote(uint8_t, uint8_t, uint8_t&);
+    void releasePotNote(uint8_t);
+    void buildNoteZones(uint8_t);
+    uint8_t getPotCCvalue(uint8_t, uint8_t);
+    bool checkPotPickup(uint8_t, uint8_t);
+    void buildCClookup();
+    void setPotOversampling();
+    void startPotSampling();
+    void stopPotSampling();
+    bool potSamplingRunning();
+    uint16_t getReadyPots(uint8_t);
+    uint16_t getPotSample(uint8_t);
+    uint16_t filterPotReading(uint8_t, uint16_t);
+    uint8_t getPotHysteresis(uint8_t);
+    void updateCCscale(uint8_t);
+    uint8_t scaleCCvalue(uint8_t, uint8_t);
+    uint8_t applyPotCurve(uint8_t, uint8_t);
+    void buildUserCurve(uint8_t);
+    void queuePotPP(uint8_t, uint8_t);
+    void checkPotPP();
     void readPotsInitial();
 
     //encoders
-    uint8_t getEncoderPairEnabled(uint8_t);
-    bool checkMemberOfEncPair(uint8_t, uint8_t);
+    bool getEncoderPairEnabled(uint8_t);
+    uint8_t processEncoderPairs(uint8_t, uint8_t);
     void processEncoderPair(uint8_t, uint8_t, uint8_t);
     uint8_t getEncoderPairNumber(uint8_t, uint8_t);
+    void (*sendEncoderDataCallback)(uint8_t, uint8_t, uint8_t);
     void (*sendPitchBendDataCallback)(uint16_t, uint8_t);
 
     //LEDs
@@ -247,16 +411,18 @@ class OpenDeck  {
     void checkBlinkLEDs();
     bool checkBlinkState(uint8_t);
     void handleLED(bool, bool, uint8_t);
-    void setLEDState();
+    void setLEDState(uint8_t, uint8_t);
     void setConstantLEDstate(uint8_t);
     void setBlinkState(uint8_t, bool);
     void switchBlinkState();
-    uint8_t getLEDnumber();
+    void buildLEDnoteMap();
+    uint8_t getLEDnumber(uint8_t);
     uint8_t getLEDnote(uint8_t);
 
     //columns
     int8_t getActiveColumn();
-    bool columnStable(uint8_t, uint8_t);
+    bool getButtonFrame(uint8_t*);
+    uint8_t debounceColumn(uint8_t, uint8_t);
 
     //sysex
     //callback
@@ -295,6 +461,12 @@ class OpenDeck  {
     bool sysExSetPotInvertState(uint8_t, bool);
     bool sysExSetCCPPnumber(uint8_t, uint8_t);
     bool sysExSetCClimit(uint8_t, uint8_t, uint8_t);
+    bool sysExSetPotHysteresis(uint8_t, uint8_t);
+    bool sysExSetPotCurve(uint8_t, uint8_t);
+    bool sysExSetUserCurvePoint(uint8_t, uint8_t);
+    bool sysExSetPotPPsettleTime(uint8_t, uint8_t);
+    bool sysExSetPotNoteZoneLayout(uint8_t, uint8_t);
+    bool sysExSetNoteZone(uint8_t, uint8_t);
     bool sysExSetLEDnote(uint8_t, uint8_t);
     bool sysExSetLEDstartNumber(uint8_t, uint8_t);
     bool sysExSetEncoderPair(uint8_t, bool);
@@ -308,8 +480,10 @@ class OpenDeck  {
 
     //hardware control
     void initBoard();
+    #if !FIXED_BOARD
+    bool boardPotsFit(uint8_t);
+    #endif
     void initPins();
-    void readButtonColumn(uint8_t &);
     void enableAnalogueInput(uint8_t, uint8_t);
 
     //new
@@ -10,9 +10,18 @@ Author: Igor Petrovic
 #include "OpenDeck.h"
 #include <avr/eeprom.h>
 #include "Ownduino.h"
+#include "Curves.h"
 
-//potentiometer must exceed this value before sending new value
-#define MIDI_CC_STEP                2
+//pots are read this many times on start-up, automatic hysteresis
+//is set to 3/4 of spread between lowest and highest reading
+#define POT_NOISE_PASSES            8
+#define POT_HYSTERESIS_AUTO_MIN     2
+
+//filter follows pot quickly once new sample differs from filtered
+//reading by this much (12-bit units, 32 is one CC step), otherwise
+//reading is smoothed by 2^shift samples
+#define POT_FILTER_FAST_THRESHOLD   32
+#define POT_FILTER_SLOW_SHIFT       3
 
 void OpenDeck::setHandlePotCC(void (*fptr)(uint8_t potNumber, uint8_t ccValue, uint8_t channel))    {
 
@@ -20,21 +29,21 @@ void OpenDeck::setHandlePotCC(void (*fptr)(uint8_t potNumber, uint8_t ccValue, u
 
 }
 
-void OpenDeck::setHandlePotNoteOn(void (*fptr)(uint8_t note, uint8_t channel))   {
+void OpenDeck::setHandlePotNote(void (*fptr)(uint8_t noteOff, uint8_t noteOffChannel, uint8_t noteOn, uint8_t noteOnChannel))   {
 
-    sendPotNoteOnDataCallback = fptr;
+    sendPotNoteDataCallback = fptr;
 
 }
 
-void OpenDeck::setHandlePotNoteOff(void (*fptr)(uint8_t note, uint8_t channel))  {
+void OpenDeck::setHandlePotPP(void (*fptr)(uint8_t channel, uint8_t program))  {
 
-    sendPotNoteOffDataCallback = fptr;
+    sendPotPPDataCallback = fptr;
 
 }
 
 uint8_t OpenDeck::getPotNumber(uint8_t muxNumber, uint8_t muxInput) {
 
-    return muxNumber*8+muxInput;
+    return muxNumber*_numberOfMuxInputs+muxInput;
 
 }
 
@@ -42,22 +51,32 @@ void OpenDeck::readPots()   {
 
     if ((_board != 0) && (bitRead(hardwareEnabled, SYS_EX_HW_CONFIG_POTS)))    {
 
-        static int8_t previousMuxNumber = -1;
-        int8_t currentMuxNumber = getActiveMux();
+        //pots have been enabled after start-up
+        if (!potSamplingRunning())  { readPotsInitial(); return; }
 
-        if (previousMuxNumber != currentMuxNumber)   {
+        //ADC interrupt samples pots on its own, only finished samples are processed here
+        for (int muxNumber=0; muxNumber<_numberOfMux; muxNumber++)  {
 
-            for (int i=0; i<8; i++) {
+            uint16_t readyPots = getReadyPots(muxNumber);
 
-                setMuxInput(i);
-                readPotsMux(i, currentMuxNumber);
+            for (int i=0; readyPots; i++, readyPots >>= 1)  {
 
-            }
+                if (!(readyPots & 0x01))    continue;
 
-            previousMuxNumber = currentMuxNumber;
+                readPotsMux(i, muxNumber, getPotSample(getPotNumber(muxNumber, i)));
+
+            }
 
         }
 
+        //send program changes of pots which have settled
+        checkPotPP();
+
+    }   else if (potSamplingRunning())  {
+
+        //don't spend time in ADC interrupt while pots are disabled
+        stopPotSampling();
+
     }
 
 }
@@ -66,32 +85,66 @@ void OpenDeck::readPotsInitial()   {
 
     if ((_board != 0) && (bitRead(hardwareEnabled, SYS_EX_HW_CONFIG_POTS)))    {
 
-        for (int muxNumber=0; muxNumber<_numberOfMux; muxNumber++)  {
+        //ADC is used directly until initial values are stored
+        stopPotSampling();
+
+        //lowest and highest reading are kept in lastAnalogueValue and potFilter
+        //until all passes are done, there's no room on stack for two more arrays
+        //all pots are read in each pass so that noise is
+        //observed over a few milliseconds, not just once
+        for (int pass=0; pass<POT_NOISE_PASSES; pass++)   {
+
+            for (int muxNumber=0; muxNumber<_numberOfMux; muxNumber++)  {
 
-            for (int muxInput=0; muxInput<8; muxInput++) {
+                for (int muxInput=0; muxInput<_numberOfMuxInputs; muxInput++) {
 
-                setMuxInput(muxInput);
-                //store read values right after reading them
-                lastAnalogueValue[getPotNumber(muxNumber, muxInput)] = analogRead(getMuxPin(muxNumber));
+                    uint8_t potNumber = getPotNumber(muxNumber, muxInput);
+
+                    setMuxInput(muxInput);
+                    //first conversion after switching mux input is discarded
+                    analogRead(getMuxPin(muxNumber));
+                    uint16_t value = analogRead(getMuxPin(muxNumber));
+
+                    if (!pass || (value < lastAnalogueValue[potNumber]))  lastAnalogueValue[potNumber] = value;
+                    if (!pass || (value > potFilter[potNumber]))          potFilter[potNumber] = value;
+
+                }
 
             }
 
         }
 
+        for (int potNumber=0; potNumber<_numberOfMux*_numberOfMuxInputs; potNumber++)    {
+
+            uint16_t noise = potFilter[potNumber] - lastAnalogueValue[potNumber];
+
+            //start from middle of noise band
+            lastAnalogueValue[potNumber] = (lastAnalogueValue[potNumber] + potFilter[potNumber] + 1) >> 1;
+            potFilter[potNumber] = lastAnalogueValue[potNumber] << 6;
+
+            noise -= noise >> 2;
+
+            if (noise < POT_HYSTERESIS_AUTO_MIN)            learnedPotHysteresis[potNumber] = POT_HYSTERESIS_AUTO_MIN;
+            else if (noise > SYS_EX_POT_HYSTERESIS_MAX)     learnedPotHysteresis[potNumber] = SYS_EX_POT_HYSTERESIS_MAX;
+            else                                            learnedPotHysteresis[potNumber] = noise;
+
+        }
+
+        startPotSampling();
+
     }
 
 }
 
-void OpenDeck::readPotsMux(uint8_t muxInput, uint8_t muxNumber)  {
+void OpenDeck::readPotsMux(uint8_t muxInput, uint8_t muxNumber, int16_t tempValue)  {
 
         //calculate pot number
         uint8_t potNumber = getPotNumber(muxNumber, muxInput);
 
-        //don't read/process data from pot if it's disabled
+        //don't process data from pot if it's been disabled meanwhile
         if (getPotEnabled(potNumber))   {
 
-            //read analogue value from mux
-            int16_t tempValue = getADCvalue();
+            tempValue = filterPotReading(potNumber, tempValue);
 
             //if new reading is stable, send new MIDI message
             if (checkPotReading(tempValue, potNumber))
@@ -108,66 +161,312 @@ uint8_t OpenDeck::getMuxPin(uint8_t muxNumber) {
 
 }
 
+uint16_t OpenDeck::filterPotReading(uint8_t potNumber, uint16_t sample)   {
+
+    /*
+
+    Adaptive exponential moving average on 12-bit oversampled samples.
+    While pot is at rest, readings are smoothed heavily so that noise
+    doesn't reach CC output. Once pot moves further than noise could
+    take it, filter follows it with little delay.
+
+    */
+
+    uint16_t filtered = potFilter[potNumber];
+    uint16_t target = sample << 4;
+    uint16_t diff = (target > filtered) ? (target - filtered) : (filtered - target);
+    uint8_t shift = POT_FILTER_SLOW_SHIFT;
+
+    //the further pot has moved, the less it's smoothed
+    if ((diff >> 4) >= 4*POT_FILTER_FAST_THRESHOLD)     shift = 0;
+    else if ((diff >> 4) >= POT_FILTER_FAST_THRESHOLD)  shift = 1;
+
+    if (target > filtered)  filtered += diff >> shift;
+    else                    filtered -= diff >> shift;
+
+    potFilter[potNumber] = filtered;
+
+    //return rounded 10-bit value
+    return (filtered + 32) >> 6;
+
+}
+
+uint8_t OpenDeck::getPotHysteresis(uint8_t potNumber)  {
+
+    if (potHysteresis[potNumber] == SYS_EX_POT_HYSTERESIS_AUTO) return learnedPotHysteresis[potNumber];
+    return potHysteresis[potNumber];
+
+}
+
+void OpenDeck::updateCCscale(uint8_t potNumber)    {
+
+    uint8_t range;
+
+    if (ccUpperLimit[potNumber] >= ccLowerLimit[potNumber]) range = ccUpperLimit[potNumber] - ccLowerLimit[potNumber];
+    else                                                    range = ccLowerLimit[potNumber] - ccUpperLimit[potNumber];
+
+    //rounded up, so that truncated product matches map() for every CC value
+    ccScale[potNumber] = ((uint32_t)range * 32768 + 126) / 127;
+
+}
+
+uint8_t OpenDeck::scaleCCvalue(uint8_t potNumber, uint8_t ccValue)  {
+
+    //same as map(ccValue, 0, 127, lower, upper), without 32-bit division
+    uint8_t offset = ((uint32_t)ccValue * ccScale[potNumber]) >> 15;
+
+    if (ccUpperLimit[potNumber] >= ccLowerLimit[potNumber]) return ccLowerLimit[potNumber] + offset;
+    return ccLowerLimit[potNumber] - offset;
+
+}
+
+uint8_t OpenDeck::applyPotCurve(uint8_t potNumber, uint8_t ccValue)    {
+
+    uint8_t curve = potCurve[potNumber];
+
+    //each curve is a 128-entry table, built-in ones in flash, user ones in EEPROM
+    if (curve == SYS_EX_POT_CURVE_LINEAR)   return ccValue;
+    if (curve >= SYS_EX_POT_CURVE_USER_1)
+        return eeprom_read_byte((uint8_t*)EEPROM_POT_USER_CURVE_TABLE_START+(curve-SYS_EX_POT_CURVE_USER_1)*128+ccValue);
+
+    return pgm_read_byte(&potCurveTable[curve-SYS_EX_POT_CURVE_LOG][ccValue]);
+
+}
+
+void OpenDeck::buildUserCurve(uint8_t curve)    {
+
+    /*
+
+        User curve is defined by SYS_EX_POT_USER_CURVE_POINTS points, evenly
+        spread between CC values 0 and 127. Values in between are linearly
+        interpolated once, when points change, so that pot reading only
+        needs one table lookup.
+
+    */
+
+    uint16_t pointAddress = EEPROM_POT_USER_CURVE_START+curve*SYS_EX_POT_USER_CURVE_POINTS;
+    uint16_t tableAddress = EEPROM_POT_USER_CURVE_TABLE_START+curve*128;
+    const uint8_t segments = SYS_EX_POT_USER_CURVE_POINTS-1;
+
+    //EEPROM written by older firmware is erased there, default points are used instead
+    bool defaultCurve = false;
+
+    for (int i=0; i<SYS_EX_POT_USER_CURVE_POINTS; i++)
+        if (eeprom_read_byte((uint8_t*)pointAddress+i) > 127)   defaultCurve = true;
+
+    for (int ccValue=0; ccValue<128; ccValue++) {
+
+        uint8_t segment = (ccValue*segments) / 127;
+        uint8_t position = (ccValue*segments) % 127;
+        uint8_t next = (segment < segments) ? segment+1 : segment;
+        int16_t start = defaultCurve ? pgm_read_byte(&(defConf[pointAddress+segment])) : eeprom_read_byte((uint8_t*)pointAddress+segment);
+        int16_t end = defaultCurve ? pgm_read_byte(&(defConf[pointAddress+next])) : eeprom_read_byte((uint8_t*)pointAddress+next);
+
+        //rounded to nearest
+        int16_t difference = (end - start) * position;
+        int16_t value = start + ((difference >= 0) ? (difference + 63) / 127 : (difference - 63) / 127);
+
+        eeprom_update_byte((uint8_t*)tableAddress+ccValue, value);
+
+    }
+
+}
+
+uint8_t OpenDeck::getPotCCvalue(uint8_t potNumber, uint8_t ccValue)  {
+
+    uint8_t ccOut = applyPotCurve(potNumber, ccValue);
+
+    //only scale value when cc limits are different from defaults
+    if ((ccLowerLimit[potNumber] != 0) || (ccUpperLimit[potNumber] != 127))
+        ccOut = scaleCCvalue(potNumber, ccOut);
+
+    return ccOut;
+
+}
+
+void OpenDeck::buildCClookup()  {
+
+    /*
+
+        Pots are stored in slot given by their CC number and, if it's
+        taken, in first free slot after it. Table is at least twice as
+        large as number of pots, so there's always a free slot which ends
+        search.
+
+    */
+
+    for (int i=0; i<POT_CC_LOOKUP_SIZE; i++)
+        potCClookup[i] = 0xFF;
+
+    for (int i=0; i<MAX_NUMBER_OF_POTS; i++)    {
+
+        uint8_t slot = ccppNumber[i] & (POT_CC_LOOKUP_SIZE-1);
+
+        while (potCClookup[slot] != 0xFF)   slot = (slot+1) & (POT_CC_LOOKUP_SIZE-1);
+
+        potCClookup[slot] = i;
+
+    }
+
+}
+
+void OpenDeck::storeReceivedControlChange(uint8_t channel, uint8_t ccNumber, uint8_t ccValue)  {
+
+    //host reports value of parameter controlled by pot, pot has
+    //to reach it before its CC messages are sent again
+    if (channel != _potCCchannel)   return;
+    if (!bitRead(potFeatures, SYS_EX_FEATURES_POTS_PICKUP)) return;
+
+    //more than one pot can use the same CC number
+    for (uint8_t slot = ccNumber & (POT_CC_LOOKUP_SIZE-1); potCClookup[slot] != 0xFF; slot = (slot+1) & (POT_CC_LOOKUP_SIZE-1))  {
+
+        uint8_t potNumber = potCClookup[slot];
+
+        if (ccppNumber[potNumber] != ccNumber)  continue;
+
+        uint8_t arrayIndex = potNumber/8;
+        uint8_t potIndex = potNumber - 8*arrayIndex;
+        uint8_t ccValuePot;
+
+        if (getPotInvertState(potNumber))   ccValuePot = 127 - (lastAnalogueValue[potNumber] >> 3);
+        else                                ccValuePot = lastAnalogueValue[potNumber] >> 3;
+
+        ccValuePot = getPotCCvalue(potNumber, ccValuePot);
+
+        //pot which is already there doesn't wait
+        if (ccValuePot == ccValue)  { potPickupTarget[potNumber] = POT_PICKUP_NONE; continue; }
+
+        potPickupTarget[potNumber] = ccValue;
+        bitWrite(potPickupAbove[arrayIndex], potIndex, ccValuePot > ccValue);
+
+    }
+
+}
+
+bool OpenDeck::checkPotPickup(uint8_t potNumber, uint8_t ccValue)   {
+
+    uint8_t target = potPickupTarget[potNumber];
+
+    if (target == POT_PICKUP_NONE)  return true;
+
+    //pickup could be disabled meanwhile
+    if (bitRead(potFeatures, SYS_EX_FEATURES_POTS_PICKUP))  {
+
+        uint8_t arrayIndex = potNumber/8;
+        uint8_t potIndex = potNumber - 8*arrayIndex;
+
+        //pot takes over once it reaches or crosses target
+        if ((ccValue != target) && ((ccValue > target) == bitRead(potPickupAbove[arrayIndex], potIndex)))
+            return false;
+
+    }
+
+    potPickupTarget[potNumber] = POT_PICKUP_NONE;
+    return true;
+
+}
+
+void OpenDeck::queuePotPP(uint8_t potNumber, uint8_t program)  {
+
+    uint8_t arrayIndex = potNumber/8;
+    uint8_t potIndex = potNumber - 8*arrayIndex;
+
+    //every move restarts settle time, program change is sent
+    //from checkPotPP once pot stays on the same program
+    potPPprogram[potNumber] = program;
+    potPPchangeTime[potNumber] = millis();
+
+    //moving back to program which has already been sent cancels it
+    bitWrite(potPPpending[arrayIndex], potIndex, program != lastPotPP[potNumber]);
+
+}
+
+void OpenDeck::checkPotPP() {
+
+    for (int i=0; i<MAX_NUMBER_OF_POTS/8; i++)  {
+
+        //most of the time there's nothing waiting
+        if (!potPPpending[i])   continue;
+
+        uint16_t time = millis();
+
+        for (int j=0; j<8; j++) {
+
+            uint8_t potNumber = 8*i+j;
+
+            if (!bitRead(potPPpending[i], j))   continue;
+            if ((uint16_t)(time - potPPchangeTime[potNumber]) < potPPsettleTime[potNumber]*10) continue;
+
+            bitClear(potPPpending[i], j);
+            lastPotPP[potNumber] = potPPprogram[potNumber];
+
+            if (sendPotPPDataCallback != NULL)
+                sendPotPPDataCallback(_potPPchannel, potPPprogram[potNumber]);
+
+        }
+
+    }
+
+}
+
 bool OpenDeck::checkPotReading(int16_t tempValue, uint8_t potNumber) {
 
     //calculate difference between current and previous reading
-    int8_t analogueDiff = tempValue - lastAnalogueValue[potNumber];
+    int16_t analogueDiff = tempValue - lastAnalogueValue[potNumber];
 
     //get absolute difference
     if (analogueDiff < 0)   analogueDiff *= -1;
 
-    if (analogueDiff >= MIDI_CC_STEP)   return true;
-    return false;
+    if ((tempValue >> 3) == (lastAnalogueValue[potNumber] >> 3))    return false;
+
+    //hysteresis larger than one CC step could keep pot from reaching end values,
+    //so reading which maps to first or last CC value is always sent
+    if (((tempValue >> 3) == 0) || ((tempValue >> 3) == 127))   return true;
+
+    //hysteresis keeps reading on the edge of two CC values from toggling
+    return (analogueDiff >= getPotHysteresis(potNumber));
 
 }
 
 void OpenDeck::processPotReading(int16_t tempValue, uint8_t potNumber)  {
 
     uint8_t ccValue;
-    uint8_t potNoteChannel = _longPressButtonNoteChannel+1;
 
     //invert CC data if potInverted is true
-    if (getPotInvertState(potNumber))   ccValue = 127 - (tempValue >> 1);
-    else                                ccValue = tempValue >> 1;
-
-    //only send data if function isn't called in setup
-    if (sendPotCCDataCallback != NULL)  {
+    if (getPotInvertState(potNumber))   ccValue = 127 - (tempValue >> 3);
+    else                                ccValue = tempValue >> 3;
 
-        //only use map when cc limits are different from defaults
-        if ((ccLowerLimit[potNumber] != 0) || (ccUpperLimit[potNumber] != 127))
-            sendPotCCDataCallback(ccppNumber[potNumber], map(ccValue, 0, 127, ccLowerLimit[potNumber], ccUpperLimit[potNumber]), _potCCchannel);
+    uint8_t ccOut = getPotCCvalue(potNumber, ccValue);
 
-        else    sendPotCCDataCallback(ccppNumber[potNumber], ccValue, _potCCchannel);
+    if (getPotPPenabled(potNumber))     queuePotPP(potNumber, ccOut);
 
-    }
+    //only send data if function isn't called in setup
+    else if ((sendPotCCDataCallback != NULL) && checkPotPickup(potNumber, ccOut))
+        sendPotCCDataCallback(ccppNumber[potNumber], ccOut, _potCCchannel);
 
     if (bitRead(potFeatures, SYS_EX_FEATURES_POTS_NOTES))  {
 
-        uint8_t noteCurrent = getPotNoteValue(ccValue, ccppNumber[potNumber]);
+        uint8_t zone = getPotNoteZone(potNumber, ccValue);
 
-        //maximum number of notes per MIDI channel is 128, with 127 being final
-        if (noteCurrent > 127)  {
+        //make sure that note is sent only once while the pot is in the same zone
+        if (zone != lastPotNoteZone[potNumber])  {
 
-            //if calculated note is bigger than 127, assign next midi channel
-            potNoteChannel += noteCurrent/128;
+            if ((sendPotNoteDataCallback != NULL) && (getPotEnabled(potNumber)))  {
 
-            //substract 128*number of overflown channels from note
-            noteCurrent -= 128*(noteCurrent/128);
+                uint8_t noteOffChannel = 0, noteOnChannel;
+                uint8_t noteOff = 128;
+                uint8_t noteOn = getPotNote(potNumber, zone, noteOnChannel);
 
-        }
+                //note off for previous zone goes out together with note on, except for the first read
+                if (lastPotNoteZone[potNumber] != POT_NOTE_ZONE_NONE)
+                    noteOff = getPotNote(potNumber, lastPotNoteZone[potNumber], noteOffChannel);
 
-        if (checkPotNoteValue(potNumber, noteCurrent))  {
+                sendPotNoteDataCallback(noteOff, noteOffChannel, noteOn, noteOnChannel);
 
-            //always send note off for previous value, except for the first read
-            if ((lastPotNoteValue[potNumber] != 128) && (sendPotNoteOffDataCallback != NULL) && (getPotEnabled(potNumber)))
-                sendPotNoteOffDataCallback(lastPotNoteValue[ccppNumber[potNumber]], _potNoteChannel);
-
-            //send note on
-            if ((sendPotNoteOnDataCallback != NULL) && (getPotEnabled(potNumber)))
-                sendPotNoteOnDataCallback(noteCurrent, _potNoteChannel);
+            }
 
-            //update last value with current
-            lastPotNoteValue[potNumber] = noteCurrent;;
+            //update last zone with current
+            lastPotNoteZone[potNumber] = zone;
 
         }
 
@@ -178,52 +477,87 @@ void OpenDeck::processPotReading(int16_t tempValue, uint8_t potNumber)  {
 
 }
 
-uint8_t OpenDeck::getPotNoteValue(uint8_t analogueMIDIvalue, uint8_t potNumber) {
+uint8_t OpenDeck::getPotNoteZone(uint8_t potNumber, uint8_t ccValue)    {
 
-    /*
+    //zone starts are sorted and end with 128, so this stops on last zone at the latest
+    const uint8_t *zoneStart = noteZoneStart[potNoteZoneLayout[potNumber]];
+    uint8_t zone = 0;
 
-    Each potentiometer alongside regular CC messages sends 6 different MIDI notes,
-    depending on it's position. In the following table x represents the reading from
-    pot and right column the MIDI note number:
+    while (ccValue >= zoneStart[zone])  zone++;
 
-    x=0:        0
-    0<x<32:     1
-    32<=x<64:   2
-    64<=x<96:   3
-    96<=x<127:  4
-    x=127:      5
+    return zone;
+
+}
+
+uint8_t OpenDeck::getPotNote(uint8_t potNumber, uint8_t zone, uint8_t &channel) {
+
+    /*
+
+    Each potentiometer alongside regular CC messages sends one MIDI note per
+    zone of its layout, numbered from CC/PP number times number of zones.
+    Notes above 127 continue from 0 on next MIDI channel(s), and aren't
+    sent at all past channel 16.
 
     */
 
-    //variable to hold current modifier value
-    uint8_t modifierValue = 6*potNumber;
+    uint16_t note = ccppNumber[potNumber]*noteZoneCount[potNoteZoneLayout[potNumber]] + zone;
+
+    channel = _potNoteChannel + (note >> 7);
+    return note & 0x7F;
 
-    switch (analogueMIDIvalue)  {
+}
 
-    case 0:
-    modifierValue += 0;
-    break;
+void OpenDeck::releasePotNote(uint8_t potNumber)    {
 
-    case 127:
-    modifierValue += 5;
-    break;
+    //turn off note which is on before pot notes get renumbered
+    if (lastPotNoteZone[potNumber] == POT_NOTE_ZONE_NONE)   return;
 
-    default:
-    modifierValue += 1 + (analogueMIDIvalue >> 5);
-    break;
+    if (sendPotNoteDataCallback != NULL)    {
+
+        uint8_t noteOffChannel;
+        uint8_t noteOff = getPotNote(potNumber, lastPotNoteZone[potNumber], noteOffChannel);
+
+        sendPotNoteDataCallback(noteOff, noteOffChannel, 128, 0);
 
     }
 
-    return modifierValue;
+    lastPotNoteZone[potNumber] = POT_NOTE_ZONE_NONE;
 
 }
 
-bool OpenDeck::checkPotNoteValue(uint8_t potNumber, uint8_t noteCurrent)    {
+void OpenDeck::buildNoteZones(uint8_t layout)    {
+
+    /*
+
+        Layout is stored as number of zones followed by CC value at which
+        each next zone starts. Starts are compiled into a table which ends
+        with 128, so that zone lookup is a short scan without any bound
+        checks. Zones which don't start above previous one are left out.
+
+    */
+
+    uint16_t eepromAddress = EEPROM_POT_NOTE_ZONE_START+layout*SYS_EX_POT_NOTE_ZONES_MAX;
+    uint8_t zones = eeprom_read_byte((uint8_t*)eepromAddress);
+    uint8_t count = 1;
+
+    //EEPROM written by older firmware is erased there, default layout is used instead
+    bool defaultLayout = (!zones || (zones > SYS_EX_POT_NOTE_ZONES_MAX));
+
+    if (defaultLayout)  zones = pgm_read_byte(&(defConf[eepromAddress]));
+
+    for (int i=1; i<zones; i++) {
+
+        uint8_t start = defaultLayout ? pgm_read_byte(&(defConf[eepromAddress+i])) : eeprom_read_byte((uint8_t*)eepromAddress+i);
+        uint8_t previous = (count > 1) ? noteZoneStart[layout][count-2] : 0;
+
+        if ((start > previous) && (start < 128))    noteZoneStart[layout][(count++)-1] = start;
+
+    }
 
-    //make sure that modifier value is sent only once while the pot is in specified range
-    if (lastPotNoteValue[potNumber] != noteCurrent) return true;
+    for (int i=count-1; i<SYS_EX_POT_NOTE_ZONES_MAX; i++)
+        noteZoneStart[layout][i] = 128;
 
-    return false;
+    noteZoneCount[layout] = count;
 
 }
 
@@ -24,6 +24,12 @@ void OpenDeck::processSysEx(uint8_t sysExArray[], uint8_t arrSize)  {
     if (sysExCheckMessageValidity(sysExArray, arrSize))
         sysExGenerateResponse(sysExArray, arrSize);
 
+    //user curves are rebuilt once, after all points in message are set
+    for (int i=0; i<SYS_EX_POT_USER_CURVES; i++)
+        if (bitRead(userCurveChanged, i))   buildUserCurve(i);
+
+    userCurveChanged = 0;
+
     _sysExRunning = false;
 
 }
@@ -215,6 +221,10 @@ bool OpenDeck::sysExCheckMessageSubType(uint8_t messageType, uint8_t messageSubT
         return ((messageSubType >= SYS_EX_MST_LED_START) && (messageSubType < SYS_EX_LED_END));
         break;
 
+        case SYS_EX_MT_ENCODER:
+        return ((messageSubType >= SYS_EX_MST_ENCODER_START) && (messageSubType < SYS_EX_MST_ENCODER_END));
+        break;
+
         case SYS_EX_MT_ALL:
         return (messageSubType == 0);
         break;
@@ -284,8 +294,21 @@ bool OpenDeck::sysExCheckParameterID(uint8_t messageType, uint8_t messageSubType
         }
 
         case SYS_EX_MT_POT:
-        return  (parameter < MAX_NUMBER_OF_POTS);
-        break;
+        switch (messageSubType) {
+
+            case SYS_EX_MST_POT_USER_CURVE_POINT:
+            return (parameter < SYS_EX_POT_USER_CURVES*SYS_EX_POT_USER_CURVE_POINTS);
+            break;
+
+            case SYS_EX_MST_POT_NOTE_ZONE:
+            return (parameter < SYS_EX_POT_NOTE_ZONE_LAYOUTS*SYS_EX_POT_NOTE_ZONES_MAX);
+            break;
+
+            default:
+            return (parameter < MAX_NUMBER_OF_POTS);
+            break;
+
+        }
 
         case SYS_EX_MT_LED:
         switch (messageSubType) {
@@ -311,6 +334,10 @@ bool OpenDeck::sysExCheckParameterID(uint8_t messageType, uint8_t messageSubType
 
         break;
 
+        case SYS_EX_MT_ENCODER:
+        return (parameter < MAX_NUMBER_OF_ENCODERS);
+        break;
+
         default:
         return false;
         break;
@@ -329,7 +356,14 @@ bool OpenDeck::sysExCheckNewParameterID(uint8_t messageType, uint8_t messageSubT
         switch(parameter)   {
 
             case SYS_EX_HW_CONFIG_BOARD:
-            return ((newParameter >= SYS_EX_BOARD_TYPE_START) && (newParameter < SYS_EX_BOARD_TYPE_END));
+            #if FIXED_BOARD
+            //firmware is built for one board only
+            return (newParameter == FIXED_BOARD);
+            #else
+            if ((newParameter < SYS_EX_BOARD_TYPE_START) || (newParameter >= SYS_EX_BOARD_TYPE_END))   return false;
+            //firmware built for fewer pots than board has would leave muxes unread
+            return ((newParameter == SYS_EX_BOARD_TYPE_START) || boardPotsFit(newParameter));
+            #endif
             break;
 
             case SYS_EX_HW_CONFIG_BUTTONS:
@@ -399,9 +433,33 @@ bool OpenDeck::sysExCheckNewParameterID(uint8_t messageType, uint8_t messageSubT
             case SYS_EX_MST_POT_CC_PP_NUMBER:
             case SYS_EX_MST_POT_LOWER_LIMIT:
             case SYS_EX_MST_POT_UPPER_LIMIT:
+            case SYS_EX_MST_POT_USER_CURVE_POINT:
             return (newParameter < 128);
             break;
 
+            case SYS_EX_MST_POT_CURVE:
+            return (newParameter < SYS_EX_POT_CURVE_END);
+            break;
+
+            case SYS_EX_MST_POT_PP_SETTLE_TIME:
+            return (newParameter <= SYS_EX_POT_PP_SETTLE_TIME_MAX);
+            break;
+
+            case SYS_EX_MST_POT_NOTE_ZONE_LAYOUT:
+            return (newParameter < SYS_EX_POT_NOTE_ZONE_LAYOUTS);
+            break;
+
+            case SYS_EX_MST_POT_NOTE_ZONE:
+            //first byte of layout is number of zones, the rest are zone starts
+            if (!(parameter % SYS_EX_POT_NOTE_ZONES_MAX))
+                return ((newParameter > 0) && (newParameter <= SYS_EX_POT_NOTE_ZONES_MAX));
+            return (newParameter < 128);
+            break;
+
+            case SYS_EX_MST_POT_HW_P:
+            return (newParameter <= SYS_EX_POT_HYSTERESIS_MAX);
+            break;
+
             default:
             return false;
             break;
@@ -451,6 +509,10 @@ bool OpenDeck::sysExCheckNewParameterID(uint8_t messageType, uint8_t messageSubT
 
         break;
 
+        case SYS_EX_MT_ENCODER:
+        return ((newParameter == SYS_EX_ENABLE) || (newParameter == SYS_EX_DISABLE));
+        break;
+
         default:
         return false;
         break;
@@ -559,8 +621,21 @@ uint8_t OpenDeck::sysExGenerateMinMessageLenght(uint8_t wish, uint8_t amount, ui
                 }
 
                 case SYS_EX_MT_POT:
-                return SYS_EX_ML_REQ_STANDARD + MAX_NUMBER_OF_POTS;
-                break;
+                switch (messageSubType) {
+
+                    case SYS_EX_MST_POT_USER_CURVE_POINT:
+                    return SYS_EX_ML_REQ_STANDARD + SYS_EX_POT_USER_CURVES*SYS_EX_POT_USER_CURVE_POINTS;
+                    break;
+
+                    case SYS_EX_MST_POT_NOTE_ZONE:
+                    return SYS_EX_ML_REQ_STANDARD + SYS_EX_POT_NOTE_ZONE_LAYOUTS*SYS_EX_POT_NOTE_ZONES_MAX;
+                    break;
+
+                    default:
+                    return SYS_EX_ML_REQ_STANDARD + MAX_NUMBER_OF_POTS;
+                    break;
+
+                }
 
                 case SYS_EX_MT_LED:
                 switch (messageSubType) {
@@ -581,6 +656,10 @@ uint8_t OpenDeck::sysExGenerateMinMessageLenght(uint8_t wish, uint8_t amount, ui
 
                 }
 
+                case SYS_EX_MT_ENCODER:
+                return SYS_EX_ML_REQ_STANDARD + MAX_NUMBER_OF_ENCODERS;
+                break;
+
                 default:
                 return 0;
                 break;
@@ -636,8 +715,8 @@ void OpenDeck::sysExGenerateResponse(uint8_t sysExArray[], uint8_t arrSize)  {
 
     int16_t maxComponentNr  = 0;
 
-    //create basic response
-    uint8_t sysExResponse[128+SYS_EX_ML_RES_BASIC];
+    //create basic response, longest one is get all buttons or LEDs
+    uint8_t sysExResponse[MAX_NUMBER_OF_BUTTONS+SYS_EX_ML_RES_BASIC];
 
     //copy first part of request to response
     for (int i=0; i<(SYS_EX_ML_RES_BASIC-1); i++)
@@ -699,7 +778,22 @@ void OpenDeck::sysExGenerateResponse(uint8_t sysExArray[], uint8_t arrSize)  {
         break;
 
         case SYS_EX_MT_POT:
-        maxComponentNr = MAX_NUMBER_OF_POTS;
+        switch (sysExArray[SYS_EX_MS_MST])  {
+
+            case SYS_EX_MST_POT_USER_CURVE_POINT:
+            maxComponentNr = SYS_EX_POT_USER_CURVES*SYS_EX_POT_USER_CURVE_POINTS;
+            break;
+
+            case SYS_EX_MST_POT_NOTE_ZONE:
+            maxComponentNr = SYS_EX_POT_NOTE_ZONE_LAYOUTS*SYS_EX_POT_NOTE_ZONES_MAX;
+            break;
+
+            default:
+            maxComponentNr = MAX_NUMBER_OF_POTS;
+            break;
+
+        }
+
         break;
 
         case SYS_EX_MT_LED:
@@ -721,6 +815,10 @@ void OpenDeck::sysExGenerateResponse(uint8_t sysExArray[], uint8_t arrSize)  {
 
         break;
 
+        case SYS_EX_MT_ENCODER:
+        maxComponentNr = MAX_NUMBER_OF_ENCODERS;
+        break;
+
         case SYS_EX_MT_ALL:
         maxComponentNr = (int16_t)sizeof(defConf);
         break;
@@ -864,6 +962,30 @@ uint8_t OpenDeck::sysExGet(uint8_t messageType, uint8_t messageSubType, uint8_t
             return ccUpperLimit[parameter];
             break;
 
+            case SYS_EX_MST_POT_HW_P:
+            return potHysteresis[parameter];
+            break;
+
+            case SYS_EX_MST_POT_CURVE:
+            return potCurve[parameter];
+            break;
+
+            case SYS_EX_MST_POT_USER_CURVE_POINT:
+            return eeprom_read_byte((uint8_t*)EEPROM_POT_USER_CURVE_START+parameter);
+            break;
+
+            case SYS_EX_MST_POT_PP_SETTLE_TIME:
+            return potPPsettleTime[parameter];
+            break;
+
+            case SYS_EX_MST_POT_NOTE_ZONE_LAYOUT:
+            return potNoteZoneLayout[parameter];
+            break;
+
+            case SYS_EX_MST_POT_NOTE_ZONE:
+            return eeprom_read_byte((uint8_t*)EEPROM_POT_NOTE_ZONE_START+parameter);
+            break;
+
             default:
             return false;
             break;
@@ -895,6 +1017,10 @@ uint8_t OpenDeck::sysExGet(uint8_t messageType, uint8_t messageSubType, uint8_t
 
         }
 
+        case SYS_EX_MT_ENCODER:
+        return getEncoderPairEnabled(parameter);
+        break;
+
         default:
         return 0;
         break;
@@ -1113,6 +1239,30 @@ bool OpenDeck::sysExSet(uint8_t messageType, uint8_t messageSubType, uint8_t par
             return sysExSetCClimit(messageSubType, parameter, newParameter);
             break;
 
+            case SYS_EX_MST_POT_HW_P:
+            return sysExSetPotHysteresis(parameter, newParameter);
+            break;
+
+            case SYS_EX_MST_POT_CURVE:
+            return sysExSetPotCurve(parameter, newParameter);
+            break;
+
+            case SYS_EX_MST_POT_USER_CURVE_POINT:
+            return sysExSetUserCurvePoint(parameter, newParameter);
+            break;
+
+            case SYS_EX_MST_POT_PP_SETTLE_TIME:
+            return sysExSetPotPPsettleTime(parameter, newParameter);
+            break;
+
+            case SYS_EX_MST_POT_NOTE_ZONE_LAYOUT:
+            return sysExSetPotNoteZoneLayout(parameter, newParameter);
+            break;
+
+            case SYS_EX_MST_POT_NOTE_ZONE:
+            return sysExSetNoteZone(parameter, newParameter);
+            break;
+
             default:
             return false;
             break;
@@ -1171,6 +1321,10 @@ bool OpenDeck::sysExSet(uint8_t messageType, uint8_t messageSubType, uint8_t par
 
         break;
 
+        case SYS_EX_MT_ENCODER:
+        return sysExSetEncoderPair(parameter, newParameter);
+        break;
+
         default:
         return false;
         break;
@@ -1277,6 +1431,30 @@ bool OpenDeck::sysExRestore(uint8_t messageType, uint8_t messageSubType, uint16_
             eepromAddress = EEPROM_POT_UPPER_LIMIT_START;
             break;
 
+            case SYS_EX_MST_POT_HW_P:
+            eepromAddress = EEPROM_POT_HYSTERESIS_START;
+            break;
+
+            case SYS_EX_MST_POT_CURVE:
+            eepromAddress = EEPROM_POT_CURVE_START;
+            break;
+
+            case SYS_EX_MST_POT_USER_CURVE_POINT:
+            eepromAddress = EEPROM_POT_USER_CURVE_START;
+            break;
+
+            case SYS_EX_MST_POT_PP_SETTLE_TIME:
+            eepromAddress = EEPROM_POT_PP_SETTLE_TIME_START;
+            break;
+
+            case SYS_EX_MST_POT_NOTE_ZONE_LAYOUT:
+            eepromAddress = EEPROM_POT_NOTE_ZONE_LAYOUT_START;
+            break;
+
+            case SYS_EX_MST_POT_NOTE_ZONE:
+            eepromAddress = EEPROM_POT_NOTE_ZONE_START;
+            break;
+
             default:
             return false;
             break;
@@ -1308,6 +1486,10 @@ bool OpenDeck::sysExRestore(uint8_t messageType, uint8_t messageSubType, uint16_
 
         break;
 
+        case SYS_EX_MT_ENCODER:
+        eepromAddress = EEPROM_ENCODER_PAIR_ENABLED_START;
+        break;
+
         case SYS_EX_MT_ALL:
         eepromAddress = 0;
         break;
@@ -1333,8 +1515,24 @@ bool OpenDeck::sysExRestore(uint8_t messageType, uint8_t messageSubType, uint16_
 
                 for (int i=0; i<componentNr; i++)    {
 
-                    if ((!sysExSet(messageType, messageSubType, _parameter, pgm_read_byte(&(defConf[eepromAddress+_parameter])))) && 
-                        (!((eeprom_read_byte((uint8_t*)eepromAddress+i)) == (pgm_read_byte(&defConf[eepromAddress+i]))))) return false;
+                    uint8_t defaultValue;
+                    uint16_t defaultAddress;
+
+                    //encoder pairs are stored as one inverted bit per pair
+                    if (messageType == SYS_EX_MT_ENCODER)   {
+
+                        defaultAddress = eepromAddress+_parameter/8;
+                        defaultValue = !bitRead(pgm_read_byte(&(defConf[defaultAddress])), _parameter%8);
+
+                    }   else    {
+
+                            defaultAddress = eepromAddress+i;
+                            defaultValue = pgm_read_byte(&(defConf[eepromAddress+_parameter]));
+
+                        }
+
+                    if ((!sysExSet(messageType, messageSubType, _parameter, defaultValue)) && 
+                        (!((eeprom_read_byte((uint8_t*)defaultAddress)) == (pgm_read_byte(&defConf[defaultAddress]))))) return false;
 
                         _parameter++;
 
@@ -1392,7 +1590,9 @@ bool OpenDeck::sysExSetHardwareConfig(uint8_t parameter, uint8_t value)  {
     switch (parameter)  {
 
         case SYS_EX_HW_CONFIG_BOARD:
+        #if !FIXED_BOARD
         _board = value;
+        #endif
         eeprom_update_byte((uint8_t*)EEPROM_BOARD_TYPE, value);
         if (eeprom_read_byte((uint8_t*)EEPROM_BOARD_TYPE) == value) { initBoard(); return true; }
         break;
@@ -1508,7 +1708,7 @@ bool OpenDeck::sysExSetButtonHwParameter(uint8_t parameter, uint8_t value)   {
         case SYS_EX_BUTTON_HW_P_LONG_PRESS_TIME:
         //long press time
         eeprom_update_byte((uint8_t*)EEPROM_BUTTON_HW_P_LONG_PRESS_TIME, value);
-        setNumberOfLongPressPasses();
+        setLongPressTime();
         return (eeprom_read_byte((uint8_t*)EEPROM_BUTTON_HW_P_LONG_PRESS_TIME) == value);
         break;
 
@@ -1574,7 +1774,9 @@ bool OpenDeck::sysExSetPotPPEnabled(uint8_t potNumber, bool state)    {
     uint16_t eepromAddress = EEPROM_POT_PP_ENABLED_START+arrayIndex;
 
     bitWrite(potPPenabled[arrayIndex], potIndex, state);
-    eeprom_update_byte((uint8_t*)eepromAddress, potEnabled[arrayIndex]);
+    //program waiting for settle time is dropped
+    bitClear(potPPpending[arrayIndex], potIndex);
+    eeprom_update_byte((uint8_t*)eepromAddress, potPPenabled[arrayIndex]);
 
     return (potPPenabled[arrayIndex] == eeprom_read_byte((uint8_t*)eepromAddress));
 
@@ -1597,7 +1799,12 @@ bool OpenDeck::sysExSetCCPPnumber(uint8_t potNumber, uint8_t _ccppNumber)   {
 
     uint16_t eepromAddress = EEPROM_POT_CC_PP_NUMBER_START+potNumber;
 
+    //pot notes are numbered from CC/PP number
+    if (ccppNumber[potNumber] != _ccppNumber)   releasePotNote(potNumber);
+
     ccppNumber[potNumber] = _ccppNumber;
+    potPickupTarget[potNumber] = POT_PICKUP_NONE;
+    buildCClookup();
     eeprom_update_byte((uint8_t*)eepromAddress, _ccppNumber);
     return (_ccppNumber == eeprom_read_byte((uint8_t*)eepromAddress));
 
@@ -1609,12 +1816,14 @@ bool OpenDeck::sysExSetCClimit(uint8_t limitType, uint8_t _ccNumber, uint8_t new
 
         case SYS_EX_MST_POT_LOWER_LIMIT:
         ccLowerLimit[_ccNumber] = newLimit;
+        updateCCscale(_ccNumber);
         eeprom_update_byte((uint8_t*)EEPROM_POT_LOWER_LIMIT_START+_ccNumber, newLimit);
         return (eeprom_read_byte((uint8_t*)EEPROM_POT_LOWER_LIMIT_START+_ccNumber) == newLimit);
         break;
 
         case SYS_EX_MST_POT_UPPER_LIMIT:
         ccUpperLimit[_ccNumber] = newLimit;
+        updateCCscale(_ccNumber);
         eeprom_update_byte((uint8_t*)EEPROM_POT_UPPER_LIMIT_START+_ccNumber, newLimit);
         return (eeprom_read_byte((uint8_t*)EEPROM_POT_UPPER_LIMIT_START+_ccNumber) == newLimit);
         break;
@@ -1627,11 +1836,83 @@ bool OpenDeck::sysExSetCClimit(uint8_t limitType, uint8_t _ccNumber, uint8_t new
 
 }
 
+bool OpenDeck::sysExSetPotHysteresis(uint8_t potNumber, uint8_t hysteresis)  {
+
+    uint16_t eepromAddress = EEPROM_POT_HYSTERESIS_START+potNumber;
+
+    potHysteresis[potNumber] = hysteresis;
+    eeprom_update_byte((uint8_t*)eepromAddress, hysteresis);
+    return (hysteresis == eeprom_read_byte((uint8_t*)eepromAddress));
+
+}
+
+bool OpenDeck::sysExSetPotCurve(uint8_t potNumber, uint8_t curve)  {
+
+    uint16_t eepromAddress = EEPROM_POT_CURVE_START+potNumber;
+
+    potCurve[potNumber] = curve;
+    eeprom_update_byte((uint8_t*)eepromAddress, curve);
+    return (curve == eeprom_read_byte((uint8_t*)eepromAddress));
+
+}
+
+bool OpenDeck::sysExSetUserCurvePoint(uint8_t pointNumber, uint8_t value)  {
+
+    uint16_t eepromAddress = EEPROM_POT_USER_CURVE_START+pointNumber;
+
+    //curve table is rebuilt after whole message is processed
+    bitSet(userCurveChanged, pointNumber/SYS_EX_POT_USER_CURVE_POINTS);
+    eeprom_update_byte((uint8_t*)eepromAddress, value);
+    return (value == eeprom_read_byte((uint8_t*)eepromAddress));
+
+}
+
+bool OpenDeck::sysExSetPotPPsettleTime(uint8_t potNumber, uint8_t settleTime)  {
+
+    uint16_t eepromAddress = EEPROM_POT_PP_SETTLE_TIME_START+potNumber;
+
+    potPPsettleTime[potNumber] = settleTime;
+    eeprom_update_byte((uint8_t*)eepromAddress, settleTime);
+    return (settleTime == eeprom_read_byte((uint8_t*)eepromAddress));
+
+}
+
+bool OpenDeck::sysExSetPotNoteZoneLayout(uint8_t potNumber, uint8_t layout)  {
+
+    uint16_t eepromAddress = EEPROM_POT_NOTE_ZONE_LAYOUT_START+potNumber;
+
+    if (potNoteZoneLayout[potNumber] != layout) releasePotNote(potNumber);
+
+    potNoteZoneLayout[potNumber] = layout;
+    eeprom_update_byte((uint8_t*)eepromAddress, layout);
+    return (layout == eeprom_read_byte((uint8_t*)eepromAddress));
+
+}
+
+bool OpenDeck::sysExSetNoteZone(uint8_t zoneParameter, uint8_t value)  {
+
+    uint16_t eepromAddress = EEPROM_POT_NOTE_ZONE_START+zoneParameter;
+    uint8_t layout = zoneParameter/SYS_EX_POT_NOTE_ZONES_MAX;
+
+    if (value == eeprom_read_byte((uint8_t*)eepromAddress)) return true;
+
+    //notes of pots using this layout are about to be renumbered
+    for (int i=0; i<MAX_NUMBER_OF_POTS; i++)
+        if (potNoteZoneLayout[i] == layout) releasePotNote(i);
+
+    eeprom_update_byte((uint8_t*)eepromAddress, value);
+    buildNoteZones(layout);
+
+    return (value == eeprom_read_byte((uint8_t*)eepromAddress));
+
+}
+
 bool OpenDeck::sysExSetLEDnote(uint8_t ledNumber, uint8_t _ledActNote) {
 
     uint16_t eepromAddress = EEPROM_LED_ACT_NOTE_START+ledNumber;
 
     ledActNote[ledNumber] = _ledActNote;
+    buildLEDnoteMap();
     //TODO: add check of same values
     eeprom_update_byte((uint8_t*)eepromAddress, _ledActNote);
     return _ledActNote == eeprom_read_byte((uint8_t*)eepromAddress);
@@ -1646,6 +1927,22 @@ bool OpenDeck::sysExSetLEDstartNumber(uint8_t startNumber, uint8_t ledNumber) {
 
 }
 
+bool OpenDeck::sysExSetEncoderPair(uint8_t encoderPair, bool state)    {
+
+    uint8_t arrayIndex = encoderPair/8;
+    uint8_t encoderIndex = encoderPair - 8*arrayIndex;
+    uint16_t eepromAddress = EEPROM_ENCODER_PAIR_ENABLED_START+arrayIndex;
+
+    bitWrite(encoderPairEnabled[arrayIndex], encoderIndex, state);
+    //partial detent is dropped, decoding starts again from next reading
+    encoderSteps[encoderPair] = 0;
+    //stored inverted, see defConf
+    eeprom_update_byte((uint8_t*)eepromAddress, ~encoderPairEnabled[arrayIndex]);
+
+    return ((uint8_t)~encoderPairEnabled[arrayIndex] == eeprom_read_byte((uint8_t*)eepromAddress));
+
+}
+
 bool OpenDeck::sysExSetDefaultConf()    {
 
     //write default configuration stored in PROGMEM to EEPROM
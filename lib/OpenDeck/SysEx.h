@@ -31,6 +31,21 @@ Author: Igor Petrovic
 #define SYS_EX_LED_START_UP_SWITCH_TIME_MIN     0x01
 #define SYS_EX_LED_START_UP_SWITCH_TIME_MAX     0x78
 
+//pot hysteresis (10-bit ADC steps), auto is learned from pot noise on start-up
+#define SYS_EX_POT_HYSTERESIS_AUTO              0x00
+#define SYS_EX_POT_HYSTERESIS_MAX               0x40
+
+//time pot has to stay on same program before program change is sent (x10 ms)
+#define SYS_EX_POT_PP_SETTLE_TIME_MAX           0x64
+
+//pot note zone layouts, each with up to SYS_EX_POT_NOTE_ZONES_MAX zones
+#define SYS_EX_POT_NOTE_ZONE_LAYOUTS            4
+#define SYS_EX_POT_NOTE_ZONES_MAX               8
+
+//user pot curves, each defined by points evenly spread over CC range
+#define SYS_EX_POT_USER_CURVES                  2
+#define SYS_EX_POT_USER_CURVE_POINTS            16
+
 ////////////////////////////////////////////////////
 
 //button types
@@ -106,6 +121,7 @@ typedef enum {
     SYS_EX_BOARD_TYPE_START,
     SYS_EX_BOARD_TYPE_OPEN_DECK_1,
     SYS_EX_BOARD_TYPE_TANNIN,
+    SYS_EX_BOARD_TYPE_TANNIN_MUX16,
     SYS_EX_BOARD_TYPE_END
 
 } sysExBoardType;
@@ -126,6 +142,7 @@ typedef enum {
 
     SYS_EX_FEATURES_MIDI_START,
     SYS_EX_FEATURES_MIDI_STANDARD_NOTE_OFF = SYS_EX_FEATURES_MIDI_START,
+    SYS_EX_FEATURES_MIDI_RUNNING_STATUS,
     SYS_EX_FEATURES_MIDI_END
 
 } sysExMIDIfeatures;
@@ -151,6 +168,7 @@ typedef enum {
 
     SYS_EX_FEATURES_POTS_START,
     SYS_EX_FEATURES_POTS_NOTES = SYS_EX_FEATURES_POTS_START,
+    SYS_EX_FEATURES_POTS_PICKUP,
     SYS_EX_FEATURES_POTS_END
 
 } sysExPotFeatures;
@@ -191,17 +209,43 @@ typedef enum {
 typedef enum {
 
     SYS_EX_MST_POT_START,
-    SYS_EX_MST_POT_HW_P = SYS_EX_MST_POT_START,
+    SYS_EX_MST_POT_HW_P = SYS_EX_MST_POT_START,    //hysteresis
     SYS_EX_MST_POT_ENABLED,
     SYS_EX_MST_POT_PP_ENABLED,
     SYS_EX_MST_POT_INVERTED,
     SYS_EX_MST_POT_CC_PP_NUMBER,
     SYS_EX_MST_POT_LOWER_LIMIT,
     SYS_EX_MST_POT_UPPER_LIMIT,
+    SYS_EX_MST_POT_CURVE,
+    SYS_EX_MST_POT_USER_CURVE_POINT,
+    SYS_EX_MST_POT_PP_SETTLE_TIME,
+    SYS_EX_MST_POT_NOTE_ZONE_LAYOUT,
+    SYS_EX_MST_POT_NOTE_ZONE,
     SYS_EX_MST_POT_END
 
 } sysExMessageSubTypePot;
 
+typedef enum {
+
+    SYS_EX_POT_CURVE_START,
+    SYS_EX_POT_CURVE_LINEAR = SYS_EX_POT_CURVE_START,
+    SYS_EX_POT_CURVE_LOG,
+    SYS_EX_POT_CURVE_EXP,
+    SYS_EX_POT_CURVE_S,
+    SYS_EX_POT_CURVE_USER_1,
+    SYS_EX_POT_CURVE_USER_2,
+    SYS_EX_POT_CURVE_END
+
+} sysExPotCurve;
+
+typedef enum {
+
+    SYS_EX_MST_ENCODER_START,
+    SYS_EX_MST_ENCODER_ENABLED = SYS_EX_MST_ENCODER_START,
+    SYS_EX_MST_ENCODER_END
+
+} sysExMessageSubTypeEncoder;
+
 typedef enum {
 
     SYS_EX_MST_LED_START,